@@ -55,7 +55,7 @@ int main(void)
 
 #ifdef USER_DEFAULT_PLATFORM
 	ili_rotate_display(1);
-#elif DSO138_PLATFORM
+#elif DSO138_PLATFORM || FSMC_PLATFORM
     ili_rotate_display(0);
 #endif
 
@@ -35,6 +35,34 @@ SOFTWARE.
      uint8_t dataSize;
      } tImage;
 
+ /*
+  * Run-length encoded RGB565 image, pixels in row major order, colors big-endian (bus order).
+  * data is a sequence of packets, each starting with a header byte h:
+  *   0x00-0x7F : literal, (h + 1) pixels follow, 2 bytes each
+  *   0x80-0xBF : run of ((h & 0x3F) + 1) pixels, one 2 byte color follows
+  *   0xC0-0xFF : run of (((h & 0x3F) << 8 | next byte) + 1) pixels, one 2 byte color follows
+  */
+ typedef struct {
+     const uint8_t *data;
+     uint32_t length;
+     uint16_t width;
+     uint16_t height;
+     } tImageRLE;
+
+ /*
+  * Palette indexed image with 1, 2, 4 or 8 bits per pixel (bpp).
+  * Each row starts on a new byte, the leftmost pixel is in the most significant bits.
+  * palette holds palette_len RGB565 colors, indices beyond it are drawn black.
+  */
+ typedef struct {
+     const uint8_t *data;
+     const uint16_t *palette;
+     uint16_t palette_len;
+     uint16_t width;
+     uint16_t height;
+     uint8_t bpp;
+     } tImageIndexed;
+
  typedef struct {
 	  const uint16_t *data;
 	  uint16_t width;
@@ -45,9 +73,20 @@ SOFTWARE.
      long int code;
      const tImage *image;
      } tChar;
+
+ /*
+  * How a glyph is found in tFont.chars. Headers that don't set `lookup` get FONT_LOOKUP_LINEAR.
+  * FONT_LOOKUP_DENSE : chars hold one contiguous range of codes, glyph index = code - chars[0].code
+  * FONT_LOOKUP_SORTED: chars are sorted by code (ascending), glyph is found by binary search
+  */
+ #define FONT_LOOKUP_LINEAR	0
+ #define FONT_LOOKUP_DENSE	1
+ #define FONT_LOOKUP_SORTED	2
+
  typedef struct {
      int length;
      const tChar *chars;
+     uint8_t lookup;
      } tFont;
 
 #endif /* INC_BITMAP_TYPEDEFS_H_ */
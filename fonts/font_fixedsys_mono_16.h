@@ -1939,4 +1939,4 @@ static const tChar font_fixedsys_mono_16_array[] = {
 
 
 
-static const tFont font_fixedsys_mono_16 = { 95, font_fixedsys_mono_16_array };
+static const tFont font_fixedsys_mono_16 = { 95, font_fixedsys_mono_16_array, FONT_LOOKUP_DENSE };
@@ -2319,4 +2319,4 @@ static const tChar font_fixedsys_mono_24_array[] = {
 
 
 
-static const tFont font_fixedsys_mono_24 = { 95, font_fixedsys_mono_24_array };
+static const tFont font_fixedsys_mono_24 = { 95, font_fixedsys_mono_24_array, FONT_LOOKUP_DENSE };
@@ -2509,4 +2509,4 @@ static const tChar font_freemono_mono_24_array[] = {
 
 
 
-static const tFont font_freemono_mono_24 = { 95, font_freemono_mono_24_array };
+static const tFont font_freemono_mono_24 = { 95, font_freemono_mono_24_array, FONT_LOOKUP_DENSE };
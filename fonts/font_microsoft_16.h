@@ -2131,6 +2131,6 @@ static const tChar Font_Microsoft_16_array[] = {
 
 };
 
-static const tFont font_microsoft_16 = { 95, Font_Microsoft_16_array };
+static const tFont font_microsoft_16 = { 95, Font_Microsoft_16_array, FONT_LOOKUP_DENSE };
 
 
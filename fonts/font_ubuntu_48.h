@@ -3600,4 +3600,4 @@ static const tChar font_ubuntu_48_array[] = {
 
 
 
-static const tFont font_ubuntu_48 = { 95, font_ubuntu_48_array };
+static const tFont font_ubuntu_48 = { 95, font_ubuntu_48_array, FONT_LOOKUP_DENSE };
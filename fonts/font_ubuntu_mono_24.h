@@ -2319,4 +2319,4 @@ static const tChar font_ubuntu_mono_24_array[] = {
 
 
 
-static const tFont font_ubuntu_mono_24 = { 95, font_ubuntu_mono_24_array };
+static const tFont font_ubuntu_mono_24 = { 95, font_ubuntu_mono_24_array, FONT_LOOKUP_DENSE };
@@ -28,6 +28,113 @@ SOFTWARE.
 uint16_t ili_tftwidth = 320;
 uint16_t ili_tftheight = 240;
 
+// Column (x1 << 16 | x2) and page (y1 << 16 | y2) ranges last sent with CASET and PASET
+static uint32_t ili_win_col = 0xFFFFFFFF;
+static uint32_t ili_win_page = 0xFFFFFFFF;
+
+// Current rotation, set by ili_rotate_display()
+static uint8_t ili_rotation = 0;
+
+// Clip rectangle (corners included) applied by every drawing function, always inside the screen
+static int16_t ili_clip_x1 = 0;
+static int16_t ili_clip_y1 = 0;
+static int16_t ili_clip_x2 = 319;
+static int16_t ili_clip_y2 = 239;
+// Clip rectangles saved by ili_clip_push()
+static struct {
+	int16_t x1, y1, x2, y2;
+} ili_clip_stack[ILI_CLIP_STACK_DEPTH];
+static uint8_t ili_clip_depth = 0;
+
+// Dirty rectangles (corners included) waiting for ili_dirty_flush()
+static struct {
+	int16_t x1, y1, x2, y2;
+} ili_dirty_rects[ILI_DIRTY_MAX_RECTS];
+static uint8_t ili_dirty_count = 0;
+
+// Scrolling area as sent with VSCRDEF / VSCRSADD, in gate line order (not rotated)
+static uint16_t ili_scroll_tfa = 0;
+static uint16_t ili_scroll_vsa = ILI_SCROLL_LINES;
+static uint16_t ili_scroll_bfa = 0;
+static uint16_t ili_scroll_vsp = 0;
+
+#ifdef ILI_USE_STATS
+// Statistics of every public function, indexed by ILI_STATS_*
+ili_stats_t ili_stats_data[ILI_STATS_COUNT];
+// Function the bus traffic is accounted to
+uint8_t ili_stats_current = ILI_STATS_OTHER;
+// ILI_STATS_CYCLES() when the current function was entered
+static uint32_t ili_stats_start;
+#endif
+
+// Called when a DMA transfer is complete
+static void (*ili_dma_callback)(void) = NULL;
+
+// Scanline set with ili_te_set_scanline()
+static uint16_t ili_te_line = 0;
+#ifdef ILI_USE_TE
+// Number of TE pulses seen, incremented by ILI_TE_ISR
+static volatile uint32_t ili_te_count = 0;
+#endif
+
+#ifdef ILI_USE_DMA
+/*
+ * State of the running DMA transfer
+ */
+static struct {
+	volatile uint8_t busy;
+	const uint8_t *src;			// bitmap bytes not yet converted, NULL while filling
+	uint32_t remaining;			// bytes not yet converted (bitmap) or queued (fill)
+	uint32_t fill_words[2];		// BSRR words of the fill color's high and low byte
+	uint8_t fill_len;			// 1 if high and low byte are identical, else 2
+	uint32_t words[2][ILI_DMA_BUF_WORDS];	// BSRR words of the bitmap, double buffered
+	uint16_t count[2];			// bytes converted into each buffer
+	uint8_t current;			// buffer being sent
+} ili_dma;
+
+// Source of the WR_LOW and WR_HIGH channels
+static const uint32_t ili_dma_wr_mask = ILI_WR;
+#endif
+
+
+/*
+ * Send CASET and PASET for the window (x1,y1)-(x2,y2), without a memory command.
+ * The display keeps them until they are changed, so only the range that differs
+ * from the last call is sent. Shared by the write (RAMWR) and read (RAMRD) paths.
+ * User need NOT call it
+ */
+static void _ili_set_window_range(uint16_t x1, uint16_t y1, uint16_t x2, uint16_t y2)
+{
+	uint32_t col = ((uint32_t)x1 << 16) | x2;
+	uint32_t page = ((uint32_t)y1 << 16) | y2;
+
+	ILI_DMA_WAIT();
+
+	if (col != ili_win_col)
+	{
+		_ili_write_command_8bit(ILI_CASET);
+
+		ILI_DC_DAT;
+		ILI_WRITE_8BIT((uint8_t)(x1 >> 8));
+		ILI_WRITE_8BIT((uint8_t)x1);
+		ILI_WRITE_8BIT((uint8_t)(x2 >> 8));
+		ILI_WRITE_8BIT((uint8_t)x2);
+		ILI_STATS_ADD(param_bytes, 4);
+		ili_win_col = col;
+	}
+
+	if (page != ili_win_page)
+	{
+		_ili_write_command_8bit(ILI_PASET);
+		ILI_DC_DAT;
+		ILI_WRITE_8BIT((uint8_t)(y1 >> 8));
+		ILI_WRITE_8BIT((uint8_t)y1);
+		ILI_WRITE_8BIT((uint8_t)(y2 >> 8));
+		ILI_WRITE_8BIT((uint8_t)y2);
+		ILI_STATS_ADD(param_bytes, 4);
+		ili_win_page = page;
+	}
+}
 
 
 /**
@@ -40,99 +147,447 @@ uint16_t ili_tftheight = 240;
  */
 void ili_set_address_window(uint16_t x1, uint16_t y1, uint16_t x2, uint16_t y2)
 {
-	_ili_write_command_8bit(ILI_CASET);
+	ILI_STATS_BEGIN(ILI_STATS_SET_ADDRESS_WINDOW);
+	ILI_STATS_ADD(window_sets, 1);
+	_ili_set_window_range(x1, y1, x2, y2);
+	// RAMWR is always sent, as it moves the write pointer back to the start of the window
+	_ili_write_command_8bit(ILI_RAMWR);
+	ILI_STATS_END();
+}
 
-	ILI_DC_DAT;
-	ILI_WRITE_8BIT((uint8_t)(x1 >> 8));
-	ILI_WRITE_8BIT((uint8_t)x1);
-	ILI_WRITE_8BIT((uint8_t)(x2 >> 8));
-	ILI_WRITE_8BIT((uint8_t)x2);
+
+/**
+ * Forget the address window cached by ili_set_address_window(), so that the next
+ * call sends both CASET and PASET again.
+ * Call it after sending CASET, PASET or a reset to the display directly.
+ */
+void ili_invalidate_address_window(void)
+{
+	ili_win_col = 0xFFFFFFFF;
+	ili_win_page = 0xFFFFFFFF;
+}
 
 
-	_ili_write_command_8bit(ILI_PASET);
-	ILI_DC_DAT;
-	ILI_WRITE_8BIT((uint8_t)(y1 >> 8));
-	ILI_WRITE_8BIT((uint8_t)y1);
-	ILI_WRITE_8BIT((uint8_t)(y2 >> 8));
-	ILI_WRITE_8BIT((uint8_t)y2);
+/**
+ * Restrict drawing to the part of the rectangle (x,y,w,h) inside the current clip rectangle.
+ * The current clip rectangle is saved, ili_clip_pop() brings it back.
+ * @param x Start col address
+ * @param y Start row address
+ * @param w Width of the rectangle
+ * @param h Height of the rectangle
+ * @return 1 if done, 0 if ILI_CLIP_STACK_DEPTH rectangles are pushed already (the clip rectangle is unchanged)
+ */
+uint8_t ili_clip_push(uint16_t x, uint16_t y, uint16_t w, uint16_t h)
+{
+	if (ili_clip_depth == ILI_CLIP_STACK_DEPTH)
+		return 0;
+	ili_clip_stack[ili_clip_depth].x1 = ili_clip_x1;
+	ili_clip_stack[ili_clip_depth].y1 = ili_clip_y1;
+	ili_clip_stack[ili_clip_depth].x2 = ili_clip_x2;
+	ili_clip_stack[ili_clip_depth].y2 = ili_clip_y2;
+	ili_clip_depth++;
+
+	int32_t x1 = x, y1 = y;
+	int32_t x2 = x1 + w - 1, y2 = y1 + h - 1;
+	if (!_ili_clip_area(&x1, &y1, &x2, &y2))
+	{
+		// Nothing left, every drawing function returns at once
+		x1 = 0;
+		y1 = 0;
+		x2 = -1;
+		y2 = -1;
+	}
+	ili_clip_x1 = x1;
+	ili_clip_y1 = y1;
+	ili_clip_x2 = x2;
+	ili_clip_y2 = y2;
+	return 1;
+}
 
-	_ili_write_command_8bit(ILI_RAMWR);
+
+/**
+ * Restore the clip rectangle saved by the last ili_clip_push()
+ */
+void ili_clip_pop(void)
+{
+	if (ili_clip_depth == 0)
+		return;
+	ili_clip_depth--;
+	ili_clip_x1 = ili_clip_stack[ili_clip_depth].x1;
+	ili_clip_y1 = ili_clip_stack[ili_clip_depth].y1;
+	ili_clip_x2 = ili_clip_stack[ili_clip_depth].x2;
+	ili_clip_y2 = ili_clip_stack[ili_clip_depth].y2;
 }
 
 
+/**
+ * Clip to the whole screen and empty the clip stack. Done by ili_init() and ili_rotate_display().
+ */
+void ili_clip_reset(void)
+{
+	ili_clip_depth = 0;
+	ili_clip_x1 = 0;
+	ili_clip_y1 = 0;
+	ili_clip_x2 = ili_tftwidth - 1;
+	ili_clip_y2 = ili_tftheight - 1;
+}
+
 
 /*
- * Render a character glyph on the display. Called by `_ili_draw_string_main()`
+ * Intersect the area (*x1,*y1)-(*x2,*y2), corners included, with the clip rectangle.
+ * Returns 0 if nothing of it is left.
  * User need NOT call it
  */
-void _ili_render_glyph(uint16_t x, uint16_t y, uint16_t fore_color, uint16_t back_color, const tImage *glyph, uint8_t is_bg)
+uint8_t _ili_clip_area(int32_t *x1, int32_t *y1, int32_t *x2, int32_t *y2)
 {
-	uint16_t width = 0, height = 0;
+	if (*x1 < ili_clip_x1)
+		*x1 = ili_clip_x1;
+	if (*y1 < ili_clip_y1)
+		*y1 = ili_clip_y1;
+	if (*x2 > ili_clip_x2)
+		*x2 = ili_clip_x2;
+	if (*y2 > ili_clip_y2)
+		*y2 = ili_clip_y2;
+	return *x1 <= *x2 && *y1 <= *y2;
+}
 
-	width = glyph->width;
-	height = glyph->height;
 
-	uint16_t temp_x = x;
-	uint16_t temp_y = y;
+/*
+ * Set the address window to the visible part of a `w` x `h` image at (x,y).
+ * `col` and `row` get the position of that part in the image, `cols` and `rows` its size.
+ * Returns 0, without setting the window, if nothing of the image is visible.
+ * User need NOT call it
+ */
+uint8_t _ili_clip_window(int32_t x, int32_t y, uint16_t w, uint16_t h, uint16_t *col, uint16_t *row, uint16_t *cols, uint16_t *rows)
+{
+	int32_t x1 = x, y1 = y;
+	int32_t x2 = x + w - 1, y2 = y + h - 1;
+
+	if (w == 0 || h == 0 || !_ili_clip_area(&x1, &y1, &x2, &y2))
+		return 0;
+	*col = x1 - x;
+	*row = y1 - y;
+	*cols = x2 - x1 + 1;
+	*rows = y2 - y1 + 1;
+	ili_set_address_window(x1, y1, x2, y2);
+	return 1;
+}
 
-	uint8_t mask = 0x80;
-	uint8_t bit_counter = 0;
 
-	const uint8_t *glyph_data_ptr = (const uint8_t *)(glyph->data);
-	uint8_t glyph_data = 0;
+/*
+ * Pixels the bounding box of dirty rectangles `a` and `b` covers on top of the two rectangles.
+ * Overlapping pixels count once, so 0 means they fit in their bounding box exactly.
+ * User need NOT call it
+ */
+static uint32_t _ili_dirty_merge_cost(uint8_t a, uint8_t b)
+{
+	int32_t ax1 = ili_dirty_rects[a].x1, ay1 = ili_dirty_rects[a].y1;
+	int32_t ax2 = ili_dirty_rects[a].x2, ay2 = ili_dirty_rects[a].y2;
+	int32_t bx1 = ili_dirty_rects[b].x1, by1 = ili_dirty_rects[b].y1;
+	int32_t bx2 = ili_dirty_rects[b].x2, by2 = ili_dirty_rects[b].y2;
+
+	int32_t box = ((ax2 > bx2 ? ax2 : bx2) - (ax1 < bx1 ? ax1 : bx1) + 1)
+			* ((ay2 > by2 ? ay2 : by2) - (ay1 < by1 ? ay1 : by1) + 1);
+	int32_t used = (ax2 - ax1 + 1) * (ay2 - ay1 + 1) + (bx2 - bx1 + 1) * (by2 - by1 + 1);
+
+	// Overlap
+	int32_t ox = (ax2 < bx2 ? ax2 : bx2) - (ax1 > bx1 ? ax1 : bx1) + 1;
+	int32_t oy = (ay2 < by2 ? ay2 : by2) - (ay1 > by1 ? ay1 : by1) + 1;
+	if (ox > 0 && oy > 0)
+		used -= ox * oy;
+	return box - used;
+}
+
+
+/*
+ * Grow dirty rectangle `a` to the bounding box of `a` and `b`, then remove `b`.
+ * User need NOT call it
+ */
+static void _ili_dirty_merge(uint8_t a, uint8_t b)
+{
+	if (ili_dirty_rects[b].x1 < ili_dirty_rects[a].x1)
+		ili_dirty_rects[a].x1 = ili_dirty_rects[b].x1;
+	if (ili_dirty_rects[b].y1 < ili_dirty_rects[a].y1)
+		ili_dirty_rects[a].y1 = ili_dirty_rects[b].y1;
+	if (ili_dirty_rects[b].x2 > ili_dirty_rects[a].x2)
+		ili_dirty_rects[a].x2 = ili_dirty_rects[b].x2;
+	if (ili_dirty_rects[b].y2 > ili_dirty_rects[a].y2)
+		ili_dirty_rects[a].y2 = ili_dirty_rects[b].y2;
+	ili_dirty_rects[b] = ili_dirty_rects[--ili_dirty_count];
+}
 
-	// font bitmaps are stored in column major order (scanned from left-to-right, not the conventional top-to-bottom)
-	// as font glyphs have heigher height than width, this scanning saves some storage.
-	// So, we also render in left-to-right manner.
 
-	// Along x axis (width)
-	for (int i = 0; i < width; i++)
+/**
+ * Mark the rectangle (x,y,w,h) as changed, to be redrawn by ili_dirty_flush().
+ * Rectangles are merged when redrawing their bounding box costs fewer bus bytes than a separate
+ * region (ILI_DIRTY_REGION_BYTES); when ILI_DIRTY_MAX_RECTS are queued, the cheapest pair is merged.
+ * @param x Start col address
+ * @param y Start row address
+ * @param w Width of the rectangle
+ * @param h Height of the rectangle
+ */
+void ili_dirty_add(uint16_t x, uint16_t y, uint16_t w, uint16_t h)
+{
+	if (w == 0 || h == 0 || x >= ili_tftwidth || y >= ili_tftheight)
+		return;
+	uint8_t n = ili_dirty_count++;
+	ili_dirty_rects[n].x1 = x;
+	ili_dirty_rects[n].y1 = y;
+	ili_dirty_rects[n].x2 = ((uint32_t)x + w > ili_tftwidth) ? ili_tftwidth - 1 : x + w - 1;
+	ili_dirty_rects[n].y2 = ((uint32_t)y + h > ili_tftheight) ? ili_tftheight - 1 : y + h - 1;
+
+	// Merge into the new rectangle `n` as long as it pays off; once grown it may reach others
+	for (uint8_t i = 0; i < ili_dirty_count; )
 	{
-		// Along y axis (height)
-		for (int j = 0; j < height; j++)
+		if (i != n && _ili_dirty_merge_cost(n, i) * 2 <= ILI_DIRTY_REGION_BYTES)
 		{
+			_ili_dirty_merge(n, i);
+			if (n == ili_dirty_count)		// n was the last slot, it was moved to i
+				n = i;
+			i = 0;
+		}
+		else
+			i++;
+	}
 
-			// load new data only when previous byte (or word, depends on glyph->dataSize) is completely traversed by the mask
-			// bit_counter = 0 means glyph_data is completely traversed by the mask
-			if (bit_counter == 0)
+	// Full: keep one slot free for the next call by merging the cheapest pair
+	if (ili_dirty_count == ILI_DIRTY_MAX_RECTS)
+	{
+		uint8_t best_a = 0, best_b = 1;
+		uint32_t best = 0xFFFFFFFF;
+		for (uint8_t a = 0; a < ili_dirty_count; a++)
+		{
+			for (uint8_t b = a + 1; b < ili_dirty_count; b++)
 			{
-				glyph_data = *glyph_data_ptr++;
-				bit_counter = glyph->dataSize;
+				uint32_t cost = _ili_dirty_merge_cost(a, b);
+				if (cost < best)
+				{
+					best = cost;
+					best_a = a;
+					best_b = b;
+				}
 			}
-			// Decrement bit counter
-			bit_counter--;
+		}
+		_ili_dirty_merge(best_a, best_b);
+	}
+}
+
+
+/**
+ * Redraw the regions marked by ili_dirty_add() and remove them from the list.
+ * For every region the clip rectangle is set to it and `redraw` is called, so the callback may
+ * simply draw everything that overlaps the region: only the region goes over the bus.
+ * @param redraw Function drawing the screen content of the region (x,y,w,h)
+ * @param ctx Passed to `redraw` unchanged
+ * @return 1 if all regions were redrawn, 0 if the clip stack was full (ILI_CLIP_STACK_DEPTH):
+ * the regions not redrawn stay in the list for the next call
+ */
+uint8_t ili_dirty_flush(ili_dirty_redraw_t redraw, void *ctx)
+{
+	uint8_t kept = 0;
+
+	ILI_STATS_BEGIN(ILI_STATS_DIRTY_FLUSH);
+	for (uint8_t i = 0; i < ili_dirty_count; i++)
+	{
+		uint16_t x = ili_dirty_rects[i].x1;
+		uint16_t y = ili_dirty_rects[i].y1;
+		uint16_t w = ili_dirty_rects[i].x2 - x + 1;
+		uint16_t h = ili_dirty_rects[i].y2 - y + 1;
+
+		if (!ili_clip_push(x, y, w, h))
+		{
+			ili_dirty_rects[kept++] = ili_dirty_rects[i];
+			continue;
+		}
+		redraw(x, y, w, h, ctx);
+		ili_clip_pop();
+	}
+	ili_dirty_count = kept;
+	ILI_STATS_END();
+	return kept == 0;
+}
+
+
+/**
+ * Forget all regions marked by ili_dirty_add(), e.g. after the whole screen was redrawn
+ */
+void ili_dirty_clear(void)
+{
+	ili_dirty_count = 0;
+}
+
+
+
+/*
+ * Find the glyph of `code` in `font` using the font's lookup method (see bitmap_typedefs.h)
+ * Returns NULL if the font has no such glyph. Called by `ili_draw_char()` and `_ili_draw_string_main()`
+ * User need NOT call it
+ */
+const tImage *_ili_get_glyph(const tFont *font, long int code)
+{
+	if (font->length <= 0)
+		return NULL;
+
+	if (font->lookup == FONT_LOOKUP_DENSE)
+	{
+		long int index = code - font->chars[0].code;
+		if (index >= 0 && index < font->length && font->chars[index].code == code)
+			return font->chars[index].image;
+		return NULL;
+	}
+
+	if (font->lookup == FONT_LOOKUP_SORTED)
+	{
+		int low = 0;
+		int high = font->length - 1;
+		while (low <= high)
+		{
+			int mid = (low + high) / 2;
+			if (font->chars[mid].code < code)
+				low = mid + 1;
+			else if (font->chars[mid].code > code)
+				high = mid - 1;
+			else
+				return font->chars[mid].image;
+		}
+		return NULL;
+	}
+
+	for (int i = 0; i < font->length; i++)
+	{
+		if (font->chars[i].code == code)
+			return font->chars[i].image;
+	}
+	return NULL;
+}
+
+
+
+/*
+ * Render a glyph with background color through one address window covering the visible
+ * part of the glyph cell.
+ * Called by `_ili_render_glyph()`
+ * User need NOT call it
+ */
+void _ili_render_glyph_bg(uint16_t x, uint16_t y, uint16_t fore_color, uint16_t back_color, const tImage *glyph)
+{
+	uint16_t height = glyph->height;
+	uint16_t col, row, cols, rows;
+
+	uint8_t fore_high = fore_color >> 8;
+	uint8_t fore_low = fore_color;
+	uint8_t back_high = back_color >> 8;
+	uint8_t back_low = back_color;
+
+	// Every glyph column starts on a new byte (see `_ili_render_glyph()`)
+	uint16_t col_bytes = (height + glyph->dataSize - 1) / glyph->dataSize;
+
+	if (!_ili_clip_window(x, y, glyph->width, height, &col, &row, &cols, &rows))
+		return;
+	ILI_STATS_ADD(pixel_bytes, (uint32_t)cols * (uint32_t)rows * 2);
+
+	// The window is filled row by row, so the column major glyph data is walked across:
+	// the bit of row j is at the same byte and mask in every column, columns are col_bytes apart.
+	ILI_DC_DAT;
+	for (uint16_t j = row; j < row + rows; j++)
+	{
+		const uint8_t *glyph_data_ptr = (const uint8_t *)(glyph->data) + j / glyph->dataSize + col * col_bytes;
+		uint8_t mask = 0x80 >> (j % glyph->dataSize);
 
+		for (uint16_t i = 0; i < cols; i++)
+		{
 			//If pixel is blank
-			if (glyph_data & mask)
+			if (*glyph_data_ptr & mask)
+			{
+				ILI_WRITE_8BIT(back_high);
+				ILI_WRITE_8BIT(back_low);
+			}
+			else
+			{
+				ILI_WRITE_8BIT(fore_high);
+				ILI_WRITE_8BIT(fore_low);
+			}
+			glyph_data_ptr += col_bytes;
+		}
+	}
+}
+
+
+
+/*
+ * Render a glyph with transparent background as vertical runs of ink pixels.
+ * Called by `_ili_render_glyph()`
+ * User need NOT call it
+ */
+void _ili_render_glyph_spans(uint16_t x, uint16_t y, uint16_t color, const tImage *glyph)
+{
+	uint16_t width = glyph->width;
+	uint16_t height = glyph->height;
+
+	const uint8_t *glyph_data_ptr = (const uint8_t *)(glyph->data);
+	uint8_t glyph_data = 0;
+	uint8_t bit_counter = 0;
+
+	// Glyph columns are the scan direction of the font data, so runs are vertical.
+	// Each run costs one 1 px wide window (CASET is cached within a column) and a pixel burst.
+	for (uint16_t i = 0; i < width; i++)
+	{
+		uint16_t col = x + i;
+		int32_t run_start = -1;
+
+		for (uint16_t j = 0; j <= height; j++)
+		{
+			uint8_t ink = 0;
+			if (j < height)
 			{
-				//Has background color (not transparent bg)
-				if (is_bg)
+				if (bit_counter == 0)
 				{
-					ili_draw_pixel(temp_x, temp_y, back_color);
+					glyph_data = *glyph_data_ptr++;
+					bit_counter = glyph->dataSize;
 				}
+				bit_counter--;
+				//Set bit means blank pixel
+				ink = !(glyph_data & 0x80);
+				glyph_data <<= 1;
 			}
 
-			//if pixel is not blank
-			else
+			if (ink && run_start < 0)
 			{
-				ili_draw_pixel(temp_x, temp_y, fore_color);
+				run_start = j;
+			}
+			else if (!ink && run_start >= 0)
+			{
+				// Emit rows run_start..j-1, clipped
+				_ili_fill_area(col, y + run_start, col, y + j - 1, color);
+				run_start = -1;
 			}
-
-			glyph_data <<= 1;
-			temp_y++;
 		}
 
-		//New col starts. So, row is set to initial value and col is increased by one
-		temp_y = y;
-		temp_x++;
-
-		//Reset the bit counter cause we're moving to next column, so we start with a new byte
+		//Every column starts with a new byte
 		bit_counter = 0;
 	}
 }
 
 
 
+/*
+ * Render a character glyph on the display. Called by `_ili_draw_string_main()`
+ * Font bitmaps are stored in column major order (scanned from left-to-right, not the conventional
+ * top-to-bottom), as glyphs are higher than wide this saves some storage. Every column starts
+ * with a new byte (or word, depends on glyph->dataSize). A set bit is a blank pixel.
+ * User need NOT call it
+ */
+void _ili_render_glyph(uint16_t x, uint16_t y, uint16_t fore_color, uint16_t back_color, const tImage *glyph, uint8_t is_bg)
+{
+	// Both renderers clip at window or span level, so partly visible glyphs cost nothing extra
+	if (is_bg)
+		_ili_render_glyph_bg(x, y, fore_color, back_color, glyph);
+	else
+		_ili_render_glyph_spans(x, y, fore_color, glyph);
+}
+
+
+
 /**
  * Renders a string by drawing each character glyph from the passed string.
  * Called by `ili_draw_string()` and `ili_draw_string_withbg()`.
@@ -168,14 +623,7 @@ void _ili_draw_string_main(uint16_t x, uint16_t y, char *str, uint16_t fore_colo
 		}
 		else
 		{
-			for (uint8_t i = 0; i < font->length; i++)
-			{
-				if (font->chars[i].code == *str)
-				{
-					img = font->chars[i].image;
-					break;
-				}
-			}
+			img = _ili_get_glyph(font, *str);
 			// No glyph (img) found, so return from this function
 			if (img == NULL)
 			{
@@ -185,7 +633,7 @@ void _ili_draw_string_main(uint16_t x, uint16_t y, char *str, uint16_t fore_colo
 			width = img->width;
 			height = img->height;
 
-			if(y_temp + (height + y_padding) > ili_tftheight - 1)	//not enough space available at the bottom
+			if (y_temp > ili_clip_y2)	//below the clip rectangle, the rest of the text can't be visible
 				return;
 			if (x_temp + (width + x_padding) > ili_tftwidth - 1)	//not enough space available at the right side
 			{
@@ -219,24 +667,18 @@ void _ili_draw_string_main(uint16_t x, uint16_t y, char *str, uint16_t fore_colo
  */
 void ili_draw_char(uint16_t x, uint16_t y, char character, uint16_t fore_color, uint16_t back_color, const tFont *font, uint8_t is_bg)
 {
-	const tImage *img = NULL;
-	for (uint8_t i = 0; i < font->length; i++)
-	{
-		if (font->chars[i].code == character)
-		{
-			img = font->chars[i].image;
-			break;
-		}
-	}
+	const tImage *img = _ili_get_glyph(font, character);
 	// No glyph (img) found, so return from this function
 	if (img == NULL)
 	{
 		return;
 	}
+	ILI_STATS_BEGIN(ILI_STATS_DRAW_CHAR);
 	if (is_bg)
 		_ili_render_glyph(x, y, fore_color, back_color, img, 1);
 	else
 		_ili_render_glyph(x, y, fore_color, back_color, img, 0);
+	ILI_STATS_END();
 }
 
 
@@ -251,7 +693,9 @@ void ili_draw_char(uint16_t x, uint16_t y, char character, uint16_t fore_color,
  */
 void ili_draw_string(uint16_t x, uint16_t y, char *str, uint16_t color, const tFont *font)
 {
+	ILI_STATS_BEGIN(ILI_STATS_DRAW_STRING);
 	_ili_draw_string_main(x, y, str, color, 0, font, 0);
+	ILI_STATS_END();
 }
 
 
@@ -267,7 +711,9 @@ void ili_draw_string(uint16_t x, uint16_t y, char *str, uint16_t color, const tF
  */
 void ili_draw_string_withbg(uint16_t x, uint16_t y, char *str, uint16_t fore_color, uint16_t back_color, const tFont *font)
 {
+	ILI_STATS_BEGIN(ILI_STATS_DRAW_STRING);
 	_ili_draw_string_main(x, y, str, fore_color, back_color, font, 1);
+	ILI_STATS_END();
 }
 
 
@@ -295,240 +741,2307 @@ void ili_draw_string_withbg(uint16_t x, uint16_t y, char *str, uint16_t fore_col
 // 	}
 // }
 
-void ili_draw_bitmap(uint16_t x, uint16_t y, const tImage *bitmap)
+/*
+ * Send `bytes` bytes that are already in bus order. Call ILI_DC_DAT first.
+ * User need NOT call it
+ */
+static void _ili_write_bytes(const uint8_t *src, uint32_t bytes)
 {
-	uint16_t width = 0, height = 0;
-	width = bitmap->width;
-	height = bitmap->height;
+#ifdef FSMC_PLATFORM
+	/*
+	* The FSMC splits a word store into four byte writes starting with the lowest address.
+	* So copy words.
+	*/
+	while (bytes && ((uintptr_t)src & 3))
+	{
+		ILI_FSMC_DATA = *src++;
+		bytes--;
+	}
+	const uint32_t *src_word = (const uint32_t *)src;
+	volatile uint32_t *bus_word = (volatile uint32_t *)&ILI_FSMC_DATA;
+	for (; bytes >= 4; bytes -= 4)
+		*bus_word = *src_word++;
+	src = (const uint8_t *)src_word;
+	while (bytes--)
+		ILI_FSMC_DATA = *src++;
+#else
+	for (; bytes >= 2; bytes -= 2)
+	{
+		ILI_WRITE_8BIT(src[0]);
+		ILI_WRITE_8BIT(src[1]);
+		src += 2;
+	}
+	if (bytes)
+		ILI_WRITE_8BIT(*src);
+#endif
+}
+
 
-	uint16_t total_pixels = width * height;
+/*
+ * Draw `w` x `h` RGB565 pixels at (x,y), clipped. Source rows start `stride` pixels apart.
+ * Called by `ili_draw_bitmap()` and `ili_draw_bitmap_part()`
+ * User need NOT call it
+ */
+static void _ili_blit(uint16_t x, uint16_t y, const uint8_t *data, uint16_t stride, uint16_t w, uint16_t h)
+{
+	uint16_t col, row, cols, rows;
 
-	ili_set_address_window(x, y, x + width-1, y + height-1);
+	if (!_ili_clip_window(x, y, w, h, &col, &row, &cols, &rows))
+		return;
+	ILI_STATS_ADD(pixel_bytes, (uint32_t)cols * (uint32_t)rows * 2);
 
+	const uint8_t *src = data + ((uint32_t)row * stride + col) * 2;
 	ILI_DC_DAT;
-	for (uint16_t pixels = 0; pixels < total_pixels; pixels++)
+	if (cols == stride)
+	{
+		// Whole rows follow each other in the image, one block
+		_ili_write_bytes(src, (uint32_t)cols * (uint32_t)rows * 2);
+	}
+	else
 	{
-		ILI_WRITE_8BIT((uint8_t)(bitmap->data[2*pixels]));
-		ILI_WRITE_8BIT((uint8_t)(bitmap->data[2*pixels + 1]));
+		for (uint16_t j = 0; j < rows; j++)
+		{
+			_ili_write_bytes(src, (uint32_t)cols * 2);
+			src += (uint32_t)stride * 2;
+		}
 	}
 }
 
 
+void ili_draw_bitmap(uint16_t x, uint16_t y, const tImage *bitmap)
+{
+	ILI_STATS_BEGIN(ILI_STATS_DRAW_BITMAP);
+	_ili_blit(x, y, bitmap->data, bitmap->width, bitmap->width, bitmap->height);
+	ILI_STATS_END();
+}
+
+
 /**
- * Fills `len` number of pixels with `color`.
- * Call ili_set_address_window() before calling this function.
- * @param color 16-bit RGB565 color value
- * @param len 32-bit number of pixels
+ * Draw the `w` x `h` part of `bitmap` starting at (src_x,src_y) of the image, e.g. one sprite
+ * of a sprite sheet. The part is cut to the image, then clipped like `ili_draw_bitmap()`.
+ * @param x Start col address on the display
+ * @param y Start row address on the display
+ * @param bitmap Pointer to the image
+ * @param src_x Start col in the image
+ * @param src_y Start row in the image
+ * @param w Width of the part
+ * @param h Height of the part
  */
-void ili_fill_color(uint16_t color, uint32_t len)
+void ili_draw_bitmap_part(uint16_t x, uint16_t y, const tImage *bitmap, uint16_t src_x, uint16_t src_y, uint16_t w, uint16_t h)
 {
-	/*
-	* Here, macros are directly called (instead of inline functions) for performance increase
-	*/
-	uint16_t blocks = (uint16_t)(len / 64); // 64 pixels/block
-	uint8_t  pass_count;
-	uint8_t color_high = color >> 8;
-	uint8_t color_low = color;
+	if (src_x >= bitmap->width || src_y >= bitmap->height)
+		return;
+	if (w > bitmap->width - src_x)
+		w = bitmap->width - src_x;
+	if (h > bitmap->height - src_y)
+		h = bitmap->height - src_y;
+
+	ILI_STATS_BEGIN(ILI_STATS_DRAW_BITMAP_PART);
+	_ili_blit(x, y, bitmap->data + ((uint32_t)src_y * bitmap->width + src_x) * 2, bitmap->width, w, h);
+	ILI_STATS_END();
+}
 
-	ILI_DC_DAT;
-	// Write first pixel
-	ILI_WRITE_8BIT(color_high); ILI_WRITE_8BIT(color_low);
-	len--;
 
-	// If higher byte and lower byte are identical,
-	// just strobe the WR pin to send the previous data
-	if(color_high == color_low)
+/**
+ * Draw a run-length encoded image on the display (format described in bitmap_typedefs.h).
+ * The image is decoded straight to the display, no RAM buffer is used.
+ * @param x Start col address
+ * @param y Start row address
+ * @param bitmap Pointer to the encoded image
+ */
+void ili_draw_bitmap_rle(uint16_t x, uint16_t y, const tImageRLE *bitmap)
+{
+	const uint8_t *src = bitmap->data;
+	const uint8_t *end = bitmap->data + bitmap->length;
+	uint16_t width = bitmap->width;
+	uint32_t remaining = (uint32_t)width * (uint32_t)bitmap->height;
+	uint16_t col, row, cols, rows;
+	uint16_t px = 0, py = 0;		// image position of the next pixel, when clipped
+
+	if (remaining == 0)
+		return;
+	ILI_STATS_BEGIN(ILI_STATS_DRAW_BITMAP_RLE);
+	if (!_ili_clip_window(x, y, width, bitmap->height, &col, &row, &cols, &rows))
+	{
+		ILI_STATS_END();
+		return;
+	}
+	uint8_t clipped = (cols != width || rows != bitmap->height);
+	// Nothing after the last visible row needs decoding
+	remaining = (uint32_t)(row + rows) * width;
+
+	while (remaining && src < end)
+	{
+		uint8_t header = *src++;
+		uint32_t count;
+		const uint8_t *literal = NULL;
+		uint16_t color = 0;
+
+		if (header & 0x80)
+		{
+			// Run: ili_fill_color() only toggles WR for the second byte when both color bytes match
+			count = (header & 0x3F) + 1;
+			if (header & 0x40)
+			{
+				if (src >= end)
+					break;
+				count = (((uint32_t)(header & 0x3F) << 8) | *src++) + 1;
+			}
+			if (end - src < 2)
+				break;
+			if (count > remaining)
+				count = remaining;
+			color = ((uint16_t)src[0] << 8) | src[1];
+			src += 2;
+		}
+		else
+		{
+			// Literal: bytes are already in bus order
+			count = header + 1;
+			if (count > remaining)
+				count = remaining;
+			if ((uint32_t)(end - src) < 2 * count)
+				break;
+			literal = src;
+			src += 2 * count;
+		}
+		remaining -= count;
+
+		while (count)
+		{
+			// Unclipped the pixels go out as they are. Clipped, image row by image row,
+			// and only the part of the row inside the window.
+			uint32_t seg = count;
+			int32_t first = 0, last = seg;
+			if (clipped)
+			{
+				if (seg > (uint32_t)(width - px))
+					seg = width - px;
+				first = (px < col) ? col - px : 0;
+				last = (px + seg > (uint32_t)(col + cols)) ? col + cols - px : (int32_t)seg;
+				if (py < row)
+					last = 0;
+			}
+			if (first < last)
+			{
+				if (literal)
+				{
+					ILI_STATS_ADD(pixel_bytes, 2 * (last - first));
+					ILI_DC_DAT;
+					for (int32_t i = 2 * first; i < 2 * last; i++)
+						ILI_WRITE_8BIT(literal[i]);
+				}
+				else
+				{
+					ili_fill_color(color, last - first);
+				}
+			}
+			if (literal)
+				literal += 2 * seg;
+			count -= seg;
+			if (clipped)
+			{
+				px += seg;
+				if (px == width)
+				{
+					px = 0;
+					py++;
+				}
+			}
+		}
+	}
+	ILI_STATS_END();
+}
+
+
+/**
+ * Draw a palette indexed image (1, 2, 4 or 8 bpp) on the display.
+ * Indices are expanded to RGB565 while streaming, no frame buffer is used.
+ * @param x Start col address
+ * @param y Start row address
+ * @param bitmap Pointer to the image data and its palette
+ */
+void ili_draw_bitmap_indexed(uint16_t x, uint16_t y, const tImageIndexed *bitmap)
+{
+	uint8_t bpp = bitmap->bpp;
+	if (bpp != 1 && bpp != 2 && bpp != 4 && bpp != 8)
+		return;
+	if (bitmap->width == 0 || bitmap->height == 0)
+		return;
+	ILI_STATS_BEGIN(ILI_STATS_DRAW_BITMAP_INDEXED);
+
+	// Palette split into bus bytes once, so the pixel loop is two table loads per pixel
+	uint8_t pal_high[256];
+	uint8_t pal_low[256];
+	uint16_t entries = 1 << bpp;
+	for (uint16_t i = 0; i < entries; i++)
+	{
+		uint16_t color = (i < bitmap->palette_len) ? bitmap->palette[i] : 0;
+		pal_high[i] = color >> 8;
+		pal_low[i] = color;
+	}
+
+	uint8_t index_mask = entries - 1;
+	uint16_t stride = ((uint32_t)bitmap->width * bpp + 7) / 8;
+	uint16_t col, row, cols, rows;
+
+	if (!_ili_clip_window(x, y, bitmap->width, bitmap->height, &col, &row, &cols, &rows))
+	{
+		ILI_STATS_END();
+		return;
+	}
+	ILI_STATS_ADD(pixel_bytes, (uint32_t)cols * (uint32_t)rows * 2);
+
+	// The first visible pixel of a row can start inside a byte
+	uint32_t first_bit = (uint32_t)col * bpp;
+	const uint8_t *line = bitmap->data + (uint32_t)row * stride + first_bit / 8;
+
+	ILI_DC_DAT;
+	for (uint16_t j = 0; j < rows; j++)
+	{
+		const uint8_t *src = line;
+		uint8_t data = 0;
+		uint8_t shift = 0;
+
+		if (first_bit % 8)
+		{
+			data = *src++;
+			shift = 8 - first_bit % 8;
+		}
+		for (uint16_t i = 0; i < cols; i++)
+		{
+			// shift = 0 means the previous byte is used up
+			if (shift == 0)
+			{
+				data = *src++;
+				shift = 8;
+			}
+			shift -= bpp;
+			uint8_t index = (data >> shift) & index_mask;
+			ILI_WRITE_8BIT(pal_high[index]);
+			ILI_WRITE_8BIT(pal_low[index]);
+		}
+		line += stride;
+	}
+	ILI_STATS_END();
+}
+
+
+/**
+ * Fills `len` number of pixels with `color`.
+ * Call ili_set_address_window() before calling this function.
+ * @param color 16-bit RGB565 color value
+ * @param len 32-bit number of pixels
+ */
+void ili_fill_color(uint16_t color, uint32_t len)
+{
+	/*
+	* Here, macros are directly called (instead of inline functions) for performance increase
+	*/
+	uint32_t blocks;
+	uint8_t  pass_count;
+	uint8_t color_high = color >> 8;
+	uint8_t color_low = color;
+
+	if (len == 0)
+		return;
+	ILI_STATS_BEGIN(ILI_STATS_FILL_COLOR);
+	ILI_DMA_WAIT();
+	ILI_STATS_ADD(pixel_bytes, len * 2);
+
+	ILI_DC_DAT;
+#ifdef FSMC_PLATFORM
+	/*
+	* No WR-only strobe on the FSMC, but a word store is split into four byte writes
+	* (lowest address first), so every store sends two pixels.
+	*/
+	uint32_t color_word = ((uint32_t)color_low << 24) | ((uint32_t)color_high << 16) | ((uint32_t)color_low << 8) | color_high;
+	volatile uint32_t *bus_word = (volatile uint32_t *)&ILI_FSMC_DATA;
+	if (len & 1)
+	{
+		ILI_WRITE_8BIT(color_high); ILI_WRITE_8BIT(color_low);
+	}
+	len >>= 1;
+	blocks = len / 8;
+	while (blocks--)
+	{
+		*bus_word = color_word; *bus_word = color_word; *bus_word = color_word; *bus_word = color_word;
+		*bus_word = color_word; *bus_word = color_word; *bus_word = color_word; *bus_word = color_word;
+	}
+	pass_count = len & 7;
+	while (pass_count--)
+		*bus_word = color_word;
+#else
+	// Write first pixel
+	ILI_WRITE_8BIT(color_high); ILI_WRITE_8BIT(color_low);
+	len--;
+	blocks = len / 64; // 64 pixels/block
+
+	// If higher byte and lower byte are identical,
+	// just strobe the WR pin to send the previous data
+	if(color_high == color_low)
+	{
+		while(blocks--)
+		{
+			// pass count = number of blocks / pixels per pass = 64 / 4
+			pass_count = 16;
+			while(pass_count--)
+			{
+				ILI_WR_STROBE; ILI_WR_STROBE; ILI_WR_STROBE; ILI_WR_STROBE; // 2
+				ILI_WR_STROBE; ILI_WR_STROBE; ILI_WR_STROBE; ILI_WR_STROBE; // 4
+			}
+		}
+		// Fill any remaining pixels (1 to 64)
+		pass_count = len & 63;
+		while (pass_count--)
+		{
+			ILI_WR_STROBE; ILI_WR_STROBE;
+		}
+	}
+
+	// If higher and lower bytes are different, send those bytes
+	else
+	{
+		while(blocks--)
+		{
+			pass_count = 16;
+			while(pass_count--)
+			{
+				ILI_WRITE_8BIT(color_high); ILI_WRITE_8BIT(color_low); 	ILI_WRITE_8BIT(color_high); ILI_WRITE_8BIT(color_low); //2
+				ILI_WRITE_8BIT(color_high); ILI_WRITE_8BIT(color_low); 	ILI_WRITE_8BIT(color_high); ILI_WRITE_8BIT(color_low); //4
+			}
+		}
+		pass_count = len & 63;
+		while (pass_count--)
+		{
+			// write here the remaining data
+			ILI_WRITE_8BIT(color_high); ILI_WRITE_8BIT(color_low);
+		}
+	}
+#endif
+	ILI_STATS_END();
+}
+
+
+#ifdef ILI_USE_DMA
+/*
+ * Configure one DMA1 channel for a memory to GPIO transfer of `number` 32-bit words
+ */
+static void _ili_dma_setup_channel(uint8_t channel, uint32_t periph, const uint32_t *mem, uint16_t number, uint8_t mem_inc)
+{
+	dma_channel_reset(DMA1, channel);
+	dma_set_peripheral_address(DMA1, channel, periph);
+	dma_set_memory_address(DMA1, channel, (uint32_t)mem);
+	dma_set_number_of_data(DMA1, channel, number);
+	dma_set_read_from_memory(DMA1, channel);
+	dma_set_peripheral_size(DMA1, channel, DMA_CCR_PSIZE_32BIT);
+	dma_set_memory_size(DMA1, channel, DMA_CCR_MSIZE_32BIT);
+	dma_set_priority(DMA1, channel, DMA_CCR_PL_VERY_HIGH);
+	if (mem_inc)
+		dma_enable_memory_increment_mode(DMA1, channel);
+}
+
+
+/*
+ * Send `count` bytes. `data` holds `data_len` BSRR words, which are repeated if
+ * `data_len` is less than `count`.
+ */
+static void _ili_dma_start_chunk(const uint32_t *data, uint16_t data_len, uint16_t count)
+{
+	_ili_dma_setup_channel(ILI_DMA_CH_DATA, (uint32_t)&GPIO_BSRR(ILI_PORT_DATA), data, data_len, 1);
+	if (data_len < count)
+		dma_enable_circular_mode(DMA1, ILI_DMA_CH_DATA);
+	_ili_dma_setup_channel(ILI_DMA_CH_WR_LOW, (uint32_t)&GPIO_BRR(ILI_PORT_WR), &ili_dma_wr_mask, count, 0);
+	_ili_dma_setup_channel(ILI_DMA_CH_WR_HIGH, (uint32_t)&GPIO_BSRR(ILI_PORT_WR), &ili_dma_wr_mask, count, 0);
+	dma_enable_transfer_complete_interrupt(DMA1, ILI_DMA_CH_WR_HIGH);
+
+	dma_enable_channel(DMA1, ILI_DMA_CH_DATA);
+	dma_enable_channel(DMA1, ILI_DMA_CH_WR_LOW);
+	dma_enable_channel(DMA1, ILI_DMA_CH_WR_HIGH);
+
+	timer_set_counter(ILI_DMA_TIMER, 0);
+	TIM_SR(ILI_DMA_TIMER) = 0;
+	timer_enable_irq(ILI_DMA_TIMER, TIM_DIER_CC1DE | TIM_DIER_CC2DE | TIM_DIER_UDE);
+	timer_enable_counter(ILI_DMA_TIMER);
+}
+
+
+/*
+ * Convert the next bitmap bytes into BSRR words of buffer `buf`
+ */
+static void _ili_dma_prepare(uint8_t buf)
+{
+	uint16_t count = (ili_dma.remaining > ILI_DMA_BUF_WORDS) ? ILI_DMA_BUF_WORDS : (uint16_t)ili_dma.remaining;
+	uint32_t *dst = ili_dma.words[buf];
+
+	for (uint16_t i = 0; i < count; i++)
+		dst[i] = 0x00FF0000 | ili_dma.src[i];
+
+	ili_dma.src += count;
+	ili_dma.remaining -= count;
+	ili_dma.count[buf] = count;
+}
+
+
+/*
+ * Queue the next fill chunk. DMA counters are 16 bit, so a full screen needs a few.
+ */
+static void _ili_dma_next_fill(void)
+{
+	// Even, so that each chunk starts with the high byte
+	uint16_t count = (ili_dma.remaining > 65534) ? 65534 : (uint16_t)ili_dma.remaining;
+
+	ili_dma.remaining -= count;
+	_ili_dma_start_chunk(ili_dma.fill_words, ili_dma.fill_len, count);
+}
+
+
+/*
+ * DMA is done, release the bus
+ */
+static void _ili_dma_finish(void)
+{
+	ili_dma.busy = 0;
+	if (ili_dma_callback)
+		ili_dma_callback();
+}
+
+
+/*
+ * Transfer complete of ILI_DMA_CH_WR_HIGH: the last byte of a chunk is latched
+ */
+void dma1_channel2_isr(void)
+{
+	uint8_t freed;
+
+	dma_clear_interrupt_flags(DMA1, ILI_DMA_CH_WR_HIGH, DMA_TCIF);
+	timer_disable_counter(ILI_DMA_TIMER);
+	// Drop pending requests so that they don't leak into the next chunk
+	timer_disable_irq(ILI_DMA_TIMER, TIM_DIER_CC1DE | TIM_DIER_CC2DE | TIM_DIER_UDE);
+	dma_disable_channel(DMA1, ILI_DMA_CH_DATA);
+	dma_disable_channel(DMA1, ILI_DMA_CH_WR_LOW);
+	dma_disable_channel(DMA1, ILI_DMA_CH_WR_HIGH);
+
+	if (ili_dma.src == NULL)
+	{
+		if (ili_dma.remaining)
+			_ili_dma_next_fill();
+		else
+			_ili_dma_finish();
+		return;
+	}
+
+	freed = ili_dma.current;
+	ili_dma.current ^= 1;
+	if (ili_dma.count[ili_dma.current] == 0)
+	{
+		_ili_dma_finish();
+		return;
+	}
+	// Keep the bus busy first, then refill the buffer that was just sent
+	_ili_dma_start_chunk(ili_dma.words[ili_dma.current], ili_dma.count[ili_dma.current], ili_dma.count[ili_dma.current]);
+	_ili_dma_prepare(freed);
+}
+
+
+/*
+ * Set up the timer and DMA used for streaming. Called by ili_init().
+ */
+static void _ili_dma_init(void)
+{
+	rcc_periph_clock_enable(RCC_DMA1);
+	rcc_periph_clock_enable(ILI_DMA_TIMER_RCC);
+
+	timer_disable_counter(ILI_DMA_TIMER);
+	timer_set_prescaler(ILI_DMA_TIMER, 0);
+	timer_set_period(ILI_DMA_TIMER, ILI_DMA_PERIOD - 1);
+	timer_set_oc_value(ILI_DMA_TIMER, TIM_OC1, 1);					// data
+	timer_set_oc_value(ILI_DMA_TIMER, TIM_OC2, ILI_DMA_PERIOD / 2);	// WR low
+																	// update: WR high
+	nvic_enable_irq(ILI_DMA_WR_HIGH_IRQ);
+	ili_dma.busy = 0;
+}
+#endif
+
+
+/**
+ * Fills `len` number of pixels with `color` using DMA and returns immediately.
+ * Call ili_set_address_window() before calling this function.
+ * Without ILI_USE_DMA it falls back to `ili_fill_color()` and completes before returning.
+ * @param color 16-bit RGB565 color value
+ * @param len 32-bit number of pixels
+ */
+void ili_dma_fill_color(uint16_t color, uint32_t len)
+{
+#ifdef ILI_USE_DMA
+	ILI_DMA_WAIT();
+	if (len == 0)
+	{
+		_ili_dma_finish();
+		return;
+	}
+	ILI_STATS_BEGIN(ILI_STATS_DMA_FILL_COLOR);
+	ILI_STATS_ADD(pixel_bytes, len * 2);
+
+	ili_dma.fill_words[0] = 0x00FF0000 | (uint8_t)(color >> 8);
+	ili_dma.fill_words[1] = 0x00FF0000 | (uint8_t)color;
+	// Identical bytes: the same word over and over
+	ili_dma.fill_len = (ili_dma.fill_words[0] == ili_dma.fill_words[1]) ? 1 : 2;
+	ili_dma.src = NULL;
+	ili_dma.remaining = len * 2;
+	ili_dma.busy = 1;
+
+	ILI_DC_DAT;
+	_ili_dma_next_fill();
+	ILI_STATS_END();
+#else
+	ILI_STATS_BEGIN(ILI_STATS_DMA_FILL_COLOR);
+	ili_fill_color(color, len);
+	ILI_STATS_END();
+	if (ili_dma_callback)
+		ili_dma_callback();
+#endif
+}
+
+
+/**
+ * Draw a bitmap image on the display using DMA and return immediately.
+ * The bitmap must stay valid until the transfer is complete.
+ * Without ILI_USE_DMA it falls back to `ili_draw_bitmap()` and completes before returning.
+ * @param x Start col address
+ * @param y Start row address
+ * @param bitmap Pointer to the image data to be drawn
+ */
+void ili_dma_draw_bitmap(uint16_t x, uint16_t y, const tImage *bitmap)
+{
+	ILI_STATS_BEGIN(ILI_STATS_DMA_DRAW_BITMAP);
+#ifdef ILI_USE_DMA
+	uint16_t col, row, cols, rows;
+
+	// DMA sends one block: only images clipped at the top or bottom (whole rows) can use it
+	if (!_ili_clip_window(x, y, bitmap->width, bitmap->height, &col, &row, &cols, &rows) || cols != bitmap->width)
+	{
+		ili_draw_bitmap(x, y, bitmap);
+		if (ili_dma_callback)
+			ili_dma_callback();
+		ILI_STATS_END();
+		return;
+	}
+
+	ili_dma.src = bitmap->data + (uint32_t)row * cols * 2;
+	ili_dma.remaining = (uint32_t)cols * (uint32_t)rows * 2;
+	_ili_dma_prepare(0);
+	_ili_dma_prepare(1);
+	if (ili_dma.count[0] == 0)
+	{
+		_ili_dma_finish();
+		ILI_STATS_END();
+		return;
+	}
+	ili_dma.current = 0;
+	ili_dma.busy = 1;
+
+	ILI_STATS_ADD(pixel_bytes, (uint32_t)cols * (uint32_t)rows * 2);
+
+	ILI_DC_DAT;
+	_ili_dma_start_chunk(ili_dma.words[0], ili_dma.count[0], ili_dma.count[0]);
+#else
+	ili_draw_bitmap(x, y, bitmap);
+	if (ili_dma_callback)
+		ili_dma_callback();
+#endif
+	ILI_STATS_END();
+}
+
+
+/**
+ * Check if a DMA transfer is still running.
+ * Other drawing functions wait for it by themselves.
+ * @return 1 if busy, 0 if done
+ */
+uint8_t ili_dma_busy(void)
+{
+#ifdef ILI_USE_DMA
+	return ili_dma.busy;
+#else
+	return 0;
+#endif
+}
+
+
+/**
+ * Set a function to be called when a DMA transfer is complete.
+ * With ILI_USE_DMA it is called from the DMA interrupt.
+ * @param callback function pointer, NULL to disable
+ */
+void ili_dma_set_callback(void (*callback)(void))
+{
+	ili_dma_callback = callback;
+}
+
+
+/*
+ * Send `bytes` bytes of a stream chunk. With DMA it returns as soon as the transfer is
+ * started, after waiting for the previous one, so the next chunk can be fetched meanwhile.
+ * Called by `ili_draw_stream()`
+ * User need NOT call it
+ */
+static void _ili_stream_send(const uint8_t *src, uint32_t bytes)
+{
+#ifdef ILI_USE_DMA
+	ILI_DMA_WAIT();
+	ili_dma.src = src;
+	ili_dma.remaining = bytes;
+	_ili_dma_prepare(0);
+	_ili_dma_prepare(1);
+	ili_dma.current = 0;
+	ili_dma.busy = 1;
+	_ili_dma_start_chunk(ili_dma.words[0], ili_dma.count[0], ili_dma.count[0]);
+#else
+	_ili_write_bytes(src, bytes);
+#endif
+}
+
+
+/**
+ * Draw a `w` x `h` RGB565 image whose pixels are pulled through `read`, e.g. from external
+ * flash or a serial link. The image is fetched in chunks of up to ILI_STREAM_BUF_BYTES, so it
+ * never has to be in memory as a whole. With ILI_USE_DMA the next chunk is fetched while the
+ * previous one is sent. Clipped like `ili_draw_bitmap()`: rows below the clip rectangle are not
+ * fetched, rows above it and hidden columns are fetched and dropped.
+ * Returns when the image is drawn; the DMA callback is not called.
+ * @param x Start col address
+ * @param y Start row address
+ * @param w Width of the image
+ * @param h Height of the image
+ * @param read Function copying up to `len` bytes of the image to `buf` (row major, 2 bytes per
+ * pixel, high byte first like tImage data). It returns the number of bytes copied, 0 stops drawing.
+ * @param ctx Passed to `read` unchanged
+ */
+void ili_draw_stream(uint16_t x, uint16_t y, uint16_t w, uint16_t h, ili_stream_read_t read, void *ctx)
+{
+	static uint8_t buf[ILI_STREAM_BUFS][ILI_STREAM_BUF_BYTES];
+	uint16_t col, row, cols, rows;
+
+	ILI_STATS_BEGIN(ILI_STATS_DRAW_STREAM);
+	if (!_ili_clip_window(x, y, w, h, &col, &row, &cols, &rows))
+	{
+		ILI_STATS_END();
+		return;
+	}
+	uint32_t row_bytes = (uint32_t)w * 2;
+	uint32_t first = (uint32_t)col * 2;					// visible bytes of a row: [first, last)
+	uint32_t last = first + (uint32_t)cols * 2;
+	uint32_t needed = (uint32_t)(row + rows) * row_bytes;	// up to the end of the last visible row
+	uint32_t pos = 0;			// byte position in the current image row
+	uint16_t py = 0;			// current image row
+	uint8_t cur = 0;			// buffer being filled
+
+#ifdef ILI_USE_DMA
+	// The transfers of one stream are not complete images
+	void (*callback)(void) = ili_dma_callback;
+	ili_dma_callback = NULL;
+#endif
+	ILI_DC_DAT;
+	while (needed)
+	{
+		uint32_t len = read(ctx, buf[cur], (needed < ILI_STREAM_BUF_BYTES) ? needed : ILI_STREAM_BUF_BYTES);
+		if (len == 0)
+			break;
+		if (len > needed)
+			len = needed;
+		needed -= len;
+
+		const uint8_t *src = buf[cur];
+		uint8_t sent = 0;
+		while (len)
+		{
+			// Part of the chunk in the current image row: bytes [pos, pos + n) of the row
+			uint32_t n = row_bytes - pos;
+			if (n > len)
+				n = len;
+			if (py >= row)
+			{
+				uint32_t a = (pos > first) ? pos : first;
+				uint32_t b = (pos + n < last) ? pos + n : last;
+				if (a < b)
+				{
+					_ili_stream_send(src + (a - pos), b - a);
+					ILI_STATS_ADD(pixel_bytes, b - a);
+					sent = 1;
+				}
+			}
+			src += n;
+			len -= n;
+			pos += n;
+			if (pos == row_bytes)
+			{
+				pos = 0;
+				py++;
+			}
+		}
+		// A buffer is refilled only after a send from the other one, which waited for it to be sent
+		if (sent)
+			cur = (cur + 1) % ILI_STREAM_BUFS;
+	}
+	ILI_DMA_WAIT();
+#ifdef ILI_USE_DMA
+	ili_dma_callback = callback;
+#endif
+	ILI_STATS_END();
+}
+
+
+#ifdef ILI_USE_TE
+/*
+ * TE pulse: the refresh has reached ili_te_line
+ */
+void ILI_TE_ISR(void)
+{
+	exti_reset_request(ILI_TE_EXTI);
+	ili_te_count++;
+}
+
+
+/*
+ * TE pin as input with a rising edge interrupt
+ * User need NOT call it
+ */
+static void _ili_te_init(void)
+{
+	// The EXTI line is mapped to the port through AFIO_EXTICR
+	rcc_periph_clock_enable(ILI_TE_RCC);
+	rcc_periph_clock_enable(RCC_AFIO);
+	gpio_set_mode(ILI_PORT_TE, GPIO_MODE_INPUT, GPIO_CNF_INPUT_FLOAT, ILI_TE);
+	exti_select_source(ILI_TE_EXTI, ILI_PORT_TE);
+	exti_set_trigger(ILI_TE_EXTI, EXTI_TRIGGER_RISING);
+	exti_enable_request(ILI_TE_EXTI);
+	nvic_enable_irq(ILI_TE_IRQ);
+}
+#endif
+
+
+/**
+ * Set the scanline at which the TE output pulses and ili_te_wait() returns.
+ * 0 is the start of vertical blanking. After ili_init() it is 0.
+ * @param line panel scanline (0 to 319)
+ */
+void ili_te_set_scanline(uint16_t line)
+{
+	ILI_STATS_BEGIN(ILI_STATS_TE_SET_SCANLINE);
+	ILI_DMA_WAIT();
+	ili_te_line = line;
+	_ili_write_command_8bit(ILI_TESCANLINE);
+	_ili_write_data_16bit(line);
+	ILI_STATS_END();
+}
+
+
+/**
+ * Read the scanline the panel is refreshing now (GET_SCANLINE)
+ * @return current scanline
+ */
+uint16_t ili_get_scanline(void)
+{
+	uint8_t high, low;
+
+	ILI_STATS_BEGIN(ILI_STATS_GET_SCANLINE);
+	ILI_DMA_WAIT();
+	_ili_write_command_8bit(ILI_GETSCANLINE);
+	ILI_STATS_ADD(read_bytes, 3);
+
+	ILI_DC_DAT;
+	ILI_DATA_INPUT();
+	ILI_READ_8BIT(low);			//dummy read
+	ILI_READ_8BIT(high);
+	ILI_READ_8BIT(low);
+	ILI_DATA_OUTPUT();
+	ILI_STATS_END();
+	return ((uint16_t)(high & 0x03) << 8) | low;
+}
+
+
+/**
+ * Wait until the panel refresh reaches the TE scanline (see ili_te_set_scanline()).
+ * Start a frame update right after it returns so the writes stay behind the refresh.
+ */
+void ili_te_wait(void)
+{
+	ILI_STATS_BEGIN(ILI_STATS_TE_WAIT);
+#ifdef ILI_USE_TE
+	uint32_t count = ili_te_count;
+	while (ili_te_count == count);
+#else
+	// No TE pin: poll until the scanline counter passes ili_te_line
+	uint16_t prev = ili_get_scanline();
+	while (1)
+	{
+		uint16_t line = ili_get_scanline();
+		if (line >= prev ? (prev < ili_te_line && ili_te_line <= line) : (prev < ili_te_line || ili_te_line <= line))
+			break;
+		prev = line;
+	}
+#endif
+	ILI_STATS_END();
+}
+
+
+#ifdef ILI_USE_STATS
+/*
+ * Called by ILI_STATS_BEGIN().
+ * Makes `api` the function the bus traffic is accounted to, unless another one
+ * is already running. Returns the function that was running before.
+ */
+uint8_t _ili_stats_begin(uint8_t api)
+{
+	uint8_t outer = ili_stats_current;
+
+	if (outer == ILI_STATS_OTHER)
+	{
+		ili_stats_current = api;
+		ili_stats_data[api].calls++;
+		ili_stats_start = ILI_STATS_CYCLES();
+	}
+	return outer;
+}
+
+
+/*
+ * Called by ILI_STATS_END().
+ * `outer` is the value returned by the matching _ili_stats_begin()
+ */
+void _ili_stats_end(uint8_t outer)
+{
+	if (outer != ILI_STATS_OTHER)
+		return;
+	ili_stats_data[ili_stats_current].cycles += ILI_STATS_CYCLES() - ili_stats_start;
+	ili_stats_current = ILI_STATS_OTHER;
+}
+
+
+/**
+ * Copy the statistics of all functions, indexed by ILI_STATS_*
+ * @param snapshot array of ILI_STATS_COUNT entries
+ */
+void ili_stats_snapshot(ili_stats_t *snapshot)
+{
+	for (uint8_t i = 0; i < ILI_STATS_COUNT; i++)
+		snapshot[i] = ili_stats_data[i];
+}
+
+
+/**
+ * Clear the statistics of all functions
+ */
+void ili_stats_reset(void)
+{
+#ifndef SIMULATOR_PLATFORM
+	dwt_enable_cycle_counter();
+#endif
+	for (uint8_t i = 0; i < ILI_STATS_COUNT; i++)
+		ili_stats_data[i] = (ili_stats_t){0};
+}
+
+
+/**
+ * Name of the function counted at index `api`
+ * @param api one of ILI_STATS_*
+ * @return function name
+ */
+const char *ili_stats_name(uint8_t api)
+{
+	static const char *const names[ILI_STATS_COUNT] = {
+		"other",
+		"ili_init",
+		"ili_rotate_display",
+		"ili_set_address_window",
+		"ili_fill_color",
+		"ili_fill_rect",
+		"ili_fill_rect_fast",
+		"ili_fill_screen",
+		"ili_draw_rectangle",
+		"ili_draw_line",
+		"ili_draw_pixel",
+		"ili_draw_char",
+		"ili_draw_string",
+		"ili_draw_bitmap",
+		"ili_dma_fill_color",
+		"ili_dma_draw_bitmap",
+		"ili_draw_bitmap_rle",
+		"ili_draw_bitmap_indexed",
+		"ili_scroll_define",
+		"ili_scroll",
+		"ili_read_rect",
+		"ili_read_pixel",
+		"ili_copy_rect",
+		"ili_te_set_scanline",
+		"ili_te_wait",
+		"ili_get_scanline",
+		"ili_write_pixels",
+		"ili_draw_circle",
+		"ili_fill_circle",
+		"ili_draw_ellipse",
+		"ili_fill_ellipse",
+		"ili_draw_round_rect",
+		"ili_fill_round_rect",
+		"ili_fill_polygon",
+		"ili_fill_triangle",
+		"ili_draw_thick_line",
+		"ili_draw_polyline",
+		"ili_draw_line_aa",
+		"ili_draw_circle_aa",
+		"ili_draw_bitmap_part",
+		"ili_draw_stream",
+		"ili_dirty_flush",
+	};
+	return (api < ILI_STATS_COUNT) ? names[api] : "";
+}
+#endif
+
+
+/**
+ * Fills a rectangular area with `color`.
+ * The area is clipped to the clip rectangle (the screen unless ili_clip_push() was called)
+ * @param x Start col address
+ * @param y Start row address
+ * @param w Width of rectangle
+ * @param h Height of rectangle
+ * @param color 16-bit RGB565 color
+ */
+void ili_fill_rect(uint16_t x, uint16_t y, uint16_t w, uint16_t h, uint16_t color)
+{
+	if (w == 0 || h == 0)
+		return;
+
+	ILI_STATS_BEGIN(ILI_STATS_FILL_RECT);
+	_ili_fill_area(x, y, (int32_t)x + w - 1, (int32_t)y + h - 1, color);
+	ILI_STATS_END();
+}
+
+
+/*
+ * Same as `ili_fill_rect()`, kept for existing code. Clipping is a few compares per call,
+ * so there is no unchecked variant any more.
+ */
+void ili_fill_rect_fast(uint16_t x1, uint16_t y1, uint16_t w, uint16_t h, uint16_t color)
+{
+	if (w == 0 || h == 0)
+		return;
+
+	ILI_STATS_BEGIN(ILI_STATS_FILL_RECT_FAST);
+	_ili_fill_area(x1, y1, (int32_t)x1 + w - 1, (int32_t)y1 + h - 1, color);
+	ILI_STATS_END();
+}
+
+
+/**
+ * Fill the entire display (screen) with `color`, or the clip rectangle if one was pushed
+ * @param color 16-bit RGB565 color
+ */
+void ili_fill_screen(uint16_t color)
+{
+	ILI_STATS_BEGIN(ILI_STATS_FILL_SCREEN);
+	_ili_fill_area(0, 0, ili_tftwidth - 1, ili_tftheight - 1, color);
+	ILI_STATS_END();
+}
+
+
+/**
+ * Draw a rectangle
+*/
+void ili_draw_rectangle(uint16_t x, uint16_t y, uint16_t w, uint16_t h, uint16_t color)
+{
+	if (w == 0 || h == 0)
+		return;
+
+	ILI_STATS_BEGIN(ILI_STATS_DRAW_RECTANGLE);
+	// The last row and column are y+h-1 and x+w-1, the sides stop short of the corners
+	_ili_draw_fast_h_line(x, y, x+w-1, 1, color);
+	if (h > 1)
+		_ili_draw_fast_h_line(x, y+h-1, x+w-1, 1, color);
+	if (h > 2)
+	{
+		_ili_draw_fast_v_line(x, y+1, y+h-2, 1, color);
+		if (w > 1)
+			_ili_draw_fast_v_line(x+w-1, y+1, y+h-2, 1, color);
+	}
+	ILI_STATS_END();
+}
+
+
+/*
+ * Fill the area (x1,y1)-(x2,y2), corners included, clipped to the clip rectangle.
+ * Coordinates may be negative or beyond the screen. Every span of the shape
+ * primitives ends up here as one address window and one ili_fill_color() burst.
+ * User need NOT call it
+ */
+void _ili_fill_area(int32_t x1, int32_t y1, int32_t x2, int32_t y2, uint16_t color)
+{
+	if (!_ili_clip_area(&x1, &y1, &x2, &y2))
+		return;
+
+	ili_set_address_window(x1, y1, x2, y2);
+	ili_fill_color(color, (uint32_t)(x2 - x1 + 1) * (uint32_t)(y2 - y1 + 1));
+}
+
+
+/*
+ * Outline of a circle of radius r split into quadrants: the right half is moved by dx,
+ * the bottom half by dy. dx = dy = 0 is a circle, otherwise the corners of a rounded rectangle.
+ * Midpoint algorithm over one octant, mirrored 8 ways. Pixels on the same row (or column
+ * in the mirrored octants) are collected into one span, and every pixel is written once:
+ * the runs on the axes span both halves, the pixel at 45 degrees goes to the rows.
+ * r = 0 is the outline of the rectangle (x0,y0)-(x0+dx,y0+dy).
+ * User need NOT call it
+ */
+void _ili_draw_circle_helper(int32_t x0, int32_t y0, int32_t r, int32_t dx, int32_t dy, uint16_t color)
+{
+	int32_t x = 0;
+	int32_t y = r;
+	int32_t d = 1 - r;
+	int32_t run = 0;		// first x of the current run on row y
+
+	if (r == 0)
+	{
+		_ili_fill_area(x0, y0, x0 + dx, y0, color);
+		if (dy > 0)
+			_ili_fill_area(x0, y0 + dy, x0 + dx, y0 + dy, color);
+		if (dy > 1)
+		{
+			_ili_fill_area(x0, y0 + 1, x0, y0 + dy - 1, color);
+			if (dx > 0)
+				_ili_fill_area(x0 + dx, y0 + 1, x0 + dx, y0 + dy - 1, color);
+		}
+		return;
+	}
+
+	while (x <= y)
+	{
+		int32_t y_next = y;
+		if (d < 0)
+		{
+			d += 2 * x + 3;
+		}
+		else
+		{
+			d += 2 * (x - y) + 5;
+			y_next--;
+		}
+
+		// Run ends when y steps or the octant is done
+		if (y_next != y || x + 1 > y_next)
+		{
+			if (run == 0)
+			{
+				// First run, across the axes (and the straight sides of a rounded rectangle)
+				_ili_fill_area(x0 - x, y0 - y, x0 + dx + x, y0 - y, color);
+				_ili_fill_area(x0 - x, y0 + dy + y, x0 + dx + x, y0 + dy + y, color);
+				_ili_fill_area(x0 + dx + y, y0 - x, x0 + dx + y, y0 + dy + x, color);
+				_ili_fill_area(x0 - y, y0 - x, x0 - y, y0 + dy + x, color);
+			}
+			else
+			{
+				// Last column of the vertical spans, without the 45 degree pixel of the rows
+				int32_t end = (x == y) ? x - 1 : x;
+
+				// Octants near the top and bottom: horizontal spans
+				_ili_fill_area(x0 + dx + run, y0 - y, x0 + dx + x, y0 - y, color);
+				_ili_fill_area(x0 - x, y0 - y, x0 - run, y0 - y, color);
+				_ili_fill_area(x0 + dx + run, y0 + dy + y, x0 + dx + x, y0 + dy + y, color);
+				_ili_fill_area(x0 - x, y0 + dy + y, x0 - run, y0 + dy + y, color);
+				// Octants near the left and right: vertical spans
+				if (run <= end)
+				{
+					_ili_fill_area(x0 + dx + y, y0 + dy + run, x0 + dx + y, y0 + dy + end, color);
+					_ili_fill_area(x0 + dx + y, y0 - end, x0 + dx + y, y0 - run, color);
+					_ili_fill_area(x0 - y, y0 + dy + run, x0 - y, y0 + dy + end, color);
+					_ili_fill_area(x0 - y, y0 - end, x0 - y, y0 - run, color);
+				}
+			}
+			run = x + 1;
+		}
+		x++;
+		y = y_next;
+	}
+}
+
+
+/*
+ * Filled circle of radius r stretched like `_ili_draw_circle_helper()`: the rows of the
+ * upper half are centered between x0 and x0 + dx, the middle rows y0..y0 + dy are one rectangle.
+ * Every row is filled exactly once.
+ * User need NOT call it
+ */
+void _ili_fill_circle_helper(int32_t x0, int32_t y0, int32_t r, int32_t dx, int32_t dy, uint16_t color)
+{
+	int32_t x = 0;
+	int32_t y = r;
+	int32_t d = 1 - r;
+
+	// Middle rows, full width
+	_ili_fill_area(x0 - r, y0, x0 + dx + r, y0 + dy, color);
+
+	while (x <= y)
+	{
+		// Row x away from the middle has a half width of y (not for x = 0, that's the middle)
+		if (x > 0)
+		{
+			_ili_fill_area(x0 - y, y0 - x, x0 + dx + y, y0 - x, color);
+			_ili_fill_area(x0 - y, y0 + dy + x, x0 + dx + y, y0 + dy + x, color);
+		}
+		if (d < 0)
+		{
+			d += 2 * x + 3;
+		}
+		else
+		{
+			// Last x on row y, so the half width of row y is x. Row y = x was filled above.
+			if (y > x)
+			{
+				_ili_fill_area(x0 - x, y0 - y, x0 + dx + x, y0 - y, color);
+				_ili_fill_area(x0 - x, y0 + dy + y, x0 + dx + x, y0 + dy + y, color);
+			}
+			d += 2 * (x - y) + 5;
+			y--;
+		}
+		x++;
+	}
+}
+
+
+/**
+ * Draw a circle outline
+ * @param x0 center col address
+ * @param y0 center row address
+ * @param r radius
+ * @param color 16-bit RGB565 color
+ */
+void ili_draw_circle(uint16_t x0, uint16_t y0, uint16_t r, uint16_t color)
+{
+	ILI_STATS_BEGIN(ILI_STATS_DRAW_CIRCLE);
+	_ili_draw_circle_helper(x0, y0, r, 0, 0, color);
+	ILI_STATS_END();
+}
+
+
+/**
+ * Draw a filled circle
+ * @param x0 center col address
+ * @param y0 center row address
+ * @param r radius
+ * @param color 16-bit RGB565 color
+ */
+void ili_fill_circle(uint16_t x0, uint16_t y0, uint16_t r, uint16_t color)
+{
+	ILI_STATS_BEGIN(ILI_STATS_FILL_CIRCLE);
+	_ili_fill_circle_helper(x0, y0, r, 0, 0, color);
+	ILI_STATS_END();
+}
+
+
+/**
+ * Draw an ellipse outline
+ * @param x0 center col address
+ * @param y0 center row address
+ * @param rx horizontal radius
+ * @param ry vertical radius
+ * @param color 16-bit RGB565 color
+ */
+void ili_draw_ellipse(uint16_t x0, uint16_t y0, uint16_t rx, uint16_t ry, uint16_t color)
+{
+	int32_t rx2 = (int32_t)rx * rx;
+	int32_t ry2 = (int32_t)ry * ry;
+	int32_t x, y, s, run;
+	int32_t ex = -1, ey = -1;		// pixel of region 1 where the slope is exactly -1
+
+	ILI_STATS_BEGIN(ILI_STATS_DRAW_ELLIPSE);
+	// A zero radius flattens the ellipse to a line, the loops below would never end
+	if (rx == 0 || ry == 0)
+	{
+		_ili_fill_area(x0 - rx, y0 - ry, x0 + rx, y0 + ry, color);
+		ILI_STATS_END();
+		return;
+	}
+
+	// Region 1, slope above -1: x steps every time, pixels of one row form a horizontal span
+	for (x = 0, y = ry, run = 0, s = 2 * ry2 + rx2 * (1 - 2 * (int32_t)ry); ry2 * x <= rx2 * y; x++)
+	{
+		int32_t y_next = y;
+		if (ry2 * x == rx2 * y)
+		{
+			ex = x;
+			ey = y;
+		}
+		if (s >= 0)
+		{
+			s += 4 * rx2 * (1 - y);
+			y_next--;
+		}
+		s += ry2 * (4 * x + 6);
+
+		if (y_next != y || ry2 * (x + 1) > rx2 * y_next)
+		{
+			if (run == 0)
+			{
+				// Across the vertical axis: one span over both halves
+				_ili_fill_area(x0 - x, y0 - y, x0 + x, y0 - y, color);
+				_ili_fill_area(x0 - x, y0 + y, x0 + x, y0 + y, color);
+			}
+			else
+			{
+				_ili_fill_area(x0 + run, y0 - y, x0 + x, y0 - y, color);
+				_ili_fill_area(x0 - x, y0 - y, x0 - run, y0 - y, color);
+				_ili_fill_area(x0 + run, y0 + y, x0 + x, y0 + y, color);
+				_ili_fill_area(x0 - x, y0 + y, x0 - run, y0 + y, color);
+			}
+			run = x + 1;
+		}
+		y = y_next;
+	}
+
+	// Region 2, slope below -1: y steps every time, pixels of one column form a vertical span
+	for (x = rx, y = 0, run = 0, s = 2 * rx2 + ry2 * (1 - 2 * (int32_t)rx); rx2 * y <= ry2 * x; y++)
+	{
+		int32_t x_next = x;
+		if (s >= 0)
+		{
+			s += 4 * ry2 * (1 - x);
+			x_next--;
+		}
+		s += rx2 * (4 * y + 6);
+
+		if (x_next != x || rx2 * (y + 1) > ry2 * x_next)
+		{
+			// Region 1 may have drawn the last pixel already
+			int32_t end = (x == ex && y == ey) ? y - 1 : y;
+
+			if (run == 0)
+			{
+				// Across the horizontal axis: one span over both halves
+				_ili_fill_area(x0 + x, y0 - end, x0 + x, y0 + end, color);
+				_ili_fill_area(x0 - x, y0 - end, x0 - x, y0 + end, color);
+			}
+			else if (run <= end)
+			{
+				_ili_fill_area(x0 + x, y0 + run, x0 + x, y0 + end, color);
+				_ili_fill_area(x0 + x, y0 - end, x0 + x, y0 - run, color);
+				_ili_fill_area(x0 - x, y0 + run, x0 - x, y0 + end, color);
+				_ili_fill_area(x0 - x, y0 - end, x0 - x, y0 - run, color);
+			}
+			run = y + 1;
+		}
+		x = x_next;
+	}
+	ILI_STATS_END();
+}
+
+
+/**
+ * Draw a filled ellipse
+ * @param x0 center col address
+ * @param y0 center row address
+ * @param rx horizontal radius
+ * @param ry vertical radius
+ * @param color 16-bit RGB565 color
+ */
+void ili_fill_ellipse(uint16_t x0, uint16_t y0, uint16_t rx, uint16_t ry, uint16_t color)
+{
+	int32_t rx2 = (int32_t)rx * rx;
+	int32_t ry2 = (int32_t)ry * ry;
+	int32_t x, y, s;
+	int32_t last_y;
+
+	ILI_STATS_BEGIN(ILI_STATS_FILL_ELLIPSE);
+	if (rx == 0 || ry == 0)
+	{
+		_ili_fill_area(x0 - rx, y0 - ry, x0 + rx, y0 + ry, color);
+		ILI_STATS_END();
+		return;
+	}
+
+	// Region 2 first, from the middle row outwards: one row per step
+	for (x = rx, y = 0, s = 2 * rx2 + ry2 * (1 - 2 * (int32_t)rx); rx2 * y <= ry2 * x; y++)
+	{
+		if (y == 0)
+			_ili_fill_area(x0 - x, y0, x0 + x, y0, color);
+		else
+		{
+			_ili_fill_area(x0 - x, y0 - y, x0 + x, y0 - y, color);
+			_ili_fill_area(x0 - x, y0 + y, x0 + x, y0 + y, color);
+		}
+		if (s >= 0)
+		{
+			s += 4 * ry2 * (1 - x);
+			x--;
+		}
+		s += rx2 * (4 * y + 6);
+	}
+	last_y = y;
+
+	// Region 1, from the top row inwards: a row is filled once, with its last (widest) x
+	for (x = 0, y = ry, s = 2 * ry2 + rx2 * (1 - 2 * (int32_t)ry); ry2 * x <= rx2 * y && y >= last_y; x++)
+	{
+		int32_t y_next = y;
+		if (s >= 0)
+		{
+			s += 4 * rx2 * (1 - y);
+			y_next--;
+		}
+		s += ry2 * (4 * x + 6);
+
+		if (y_next != y || ry2 * (x + 1) > rx2 * y_next)
+		{
+			_ili_fill_area(x0 - x, y0 - y, x0 + x, y0 - y, color);
+			if (y > 0)
+				_ili_fill_area(x0 - x, y0 + y, x0 + x, y0 + y, color);
+		}
+		y = y_next;
+	}
+	ILI_STATS_END();
+}
+
+
+/**
+ * Draw a rectangle with rounded corners
+ * @param x start column address
+ * @param y start row address
+ * @param w width of rectangle
+ * @param h height of rectangle
+ * @param r corner radius, limited to half of the shorter side
+ * @param color 16-bit RGB565 color
+ */
+void ili_draw_round_rect(uint16_t x, uint16_t y, uint16_t w, uint16_t h, uint16_t r, uint16_t color)
+{
+	if (w == 0 || h == 0)
+		return;
+	if (r > (w - 1) / 2)
+		r = (w - 1) / 2;
+	if (r > (h - 1) / 2)
+		r = (h - 1) / 2;
+
+	ILI_STATS_BEGIN(ILI_STATS_DRAW_ROUND_RECT);
+	int32_t x1 = x + r;					// left corner centers
+	int32_t y1 = y + r;					// top corner centers
+	int32_t dx = w - 1 - 2 * r;			// distance to the right corner centers
+	int32_t dy = h - 1 - 2 * r;			// distance to the bottom corner centers
+
+	// The corners and the straight sides between them
+	_ili_draw_circle_helper(x1, y1, r, dx, dy, color);
+	ILI_STATS_END();
+}
+
+
+/**
+ * Draw a filled rectangle with rounded corners
+ * @param x start column address
+ * @param y start row address
+ * @param w width of rectangle
+ * @param h height of rectangle
+ * @param r corner radius, limited to half of the shorter side
+ * @param color 16-bit RGB565 color
+ */
+void ili_fill_round_rect(uint16_t x, uint16_t y, uint16_t w, uint16_t h, uint16_t r, uint16_t color)
+{
+	if (w == 0 || h == 0)
+		return;
+	if (r > (w - 1) / 2)
+		r = (w - 1) / 2;
+	if (r > (h - 1) / 2)
+		r = (h - 1) / 2;
+
+	ILI_STATS_BEGIN(ILI_STATS_FILL_ROUND_RECT);
+	_ili_fill_circle_helper(x + r, y + r, r, w - 1 - 2 * r, h - 1 - 2 * r, color);
+	ILI_STATS_END();
+}
+
+
+/*
+ * floor(n / d) for d > 0
+ * User need NOT call it
+ */
+static int32_t _ili_div_floor(int64_t n, int32_t d)
+{
+	int64_t q = n / d;
+	if (q * d > n)
+		q--;
+	return (int32_t)q;
+}
+
+
+/*
+ * Fill a polygon whose vertices are given in 1/(1 << shift) pixel units. Vertices are pixel
+ * corners: a pixel is filled when its center lies inside, so polygons sharing an edge never
+ * overlap or leave a gap between them.
+ * Edges are walked with an integer quotient and remainder (like Bresenham), so the crossing of
+ * every row is exact. Every row is one span per inside run.
+ * Nothing is drawn for more than ILI_POLYGON_MAX_POINTS vertices.
+ * User need NOT call it
+ */
+void _ili_fill_polygon(const ili_point_t *points, uint16_t count, uint8_t shift, uint8_t rule, uint16_t color)
+{
+	/*
+	 * Edge table. An edge covers the rows ey1 to ey2 - 1. The first pixel right of its crossing
+	 * with the current row is eq + (er > 0), the crossing moves by esq + esr / eden per row.
+	 */
+	static int16_t ey1[ILI_POLYGON_MAX_POINTS], ey2[ILI_POLYGON_MAX_POINTS];
+	static int32_t eq[ILI_POLYGON_MAX_POINTS], er[ILI_POLYGON_MAX_POINTS];
+	static int32_t esq[ILI_POLYGON_MAX_POINTS], esr[ILI_POLYGON_MAX_POINTS], eden[ILI_POLYGON_MAX_POINTS];
+	static int8_t ewind[ILI_POLYGON_MAX_POINTS];
+	// Crossings of the current row (first pixel right of them), sorted
+	static int32_t cx[ILI_POLYGON_MAX_POINTS];
+	static int8_t cwind[ILI_POLYGON_MAX_POINTS];
+	// Coordinates are doubled, so the pixel centers (half a pixel) are integers too
+	int32_t half = 1 << shift;
+	int32_t unit = 2 * half;
+	uint16_t edges = 0;
+	int32_t ymin = INT16_MAX, ymax = INT16_MIN;
+
+	if (count < 3 || count > ILI_POLYGON_MAX_POINTS)
+		return;
+
+	for (uint16_t i = 0; i < count; i++)
+	{
+		const ili_point_t *a = &points[i];
+		const ili_point_t *b = &points[(i + 1 == count) ? 0 : i + 1];
+		int8_t wind = 1;
+
+		if (a->y > b->y)
+		{
+			const ili_point_t *t = a;
+			a = b;
+			b = t;
+			wind = -1;
+		}
+
+		// Rows whose center is in [a->y, b->y), rows above the clip rectangle are skipped
+		int32_t y1 = -_ili_div_floor(half - 2 * a->y, unit);
+		int32_t y2 = -_ili_div_floor(half - 2 * b->y, unit);
+		if (y1 < ili_clip_y1)
+			y1 = ili_clip_y1;
+		if (y1 >= y2)
+			continue;				// horizontal, too short to cross a row center or clipped
+
+		/*
+		 * First pixel right of the crossing with row y: ceil(n / den) with
+		 * n = (2ax - half) * 2dy + (y * unit + half - 2ay) * 2dx, den = unit * 2dy
+		 */
+		int32_t dx = 2 * (b->x - a->x);
+		int32_t dy = 2 * (b->y - a->y);
+		int32_t den = unit * dy;
+		int64_t n = (int64_t)(2 * a->x - half) * dy + (int64_t)(y1 * unit + half - 2 * a->y) * dx;
+		eq[edges] = _ili_div_floor(n, den);
+		er[edges] = (int32_t)(n - (int64_t)eq[edges] * den);
+		esq[edges] = _ili_div_floor((int64_t)unit * dx, den);
+		esr[edges] = unit * dx - esq[edges] * den;
+		eden[edges] = den;
+		ey1[edges] = y1;
+		ey2[edges] = y2;
+		ewind[edges] = wind;
+		if (y1 < ymin)
+			ymin = y1;
+		if (y2 > ymax)
+			ymax = y2;
+		edges++;
+	}
+	if (ymax > ili_clip_y2 + 1)
+		ymax = ili_clip_y2 + 1;
+
+	for (int32_t y = ymin; y < ymax; y++)
+	{
+		uint16_t n = 0;
+
+		// Active edges, insertion sorted by crossing
+		for (uint16_t i = 0; i < edges; i++)
+		{
+			if (y < ey1[i] || y >= ey2[i])
+				continue;
+			int32_t x = eq[i] + (er[i] > 0);
+			uint16_t j = n++;
+			while (j > 0 && cx[j - 1] > x)
+			{
+				cx[j] = cx[j - 1];
+				cwind[j] = cwind[j - 1];
+				j--;
+			}
+			cx[j] = x;
+			cwind[j] = ewind[i];
+
+			eq[i] += esq[i];
+			er[i] += esr[i];
+			if (er[i] >= eden[i])
+			{
+				er[i] -= eden[i];
+				eq[i]++;
+			}
+		}
+
+		// Inside runs: between crossing pairs (even-odd) or where the winding number is not 0
+		int32_t wind = 0;
+		for (uint16_t j = 0; j < n; j++)
+		{
+			int32_t x1 = cx[j];
+			if (rule == ILI_FILL_EVEN_ODD)
+			{
+				if (++j == n)
+					break;
+			}
+			else
+			{
+				wind += cwind[j];
+				while (wind != 0 && ++j < n)
+					wind += cwind[j];
+				if (j == n)
+					break;
+			}
+			if (x1 < cx[j])
+				_ili_fill_area(x1, y, cx[j] - 1, y, color);
+		}
+	}
+}
+
+
+/**
+ * Fill a polygon. Vertices are pixel corners: a pixel is filled when its center lies inside,
+ * so polygons sharing an edge never overlap or leave a gap between them.
+ * @param points vertices, the last one is joined to the first one. Coordinates may be off-screen.
+ * @param count number of vertices, up to ILI_POLYGON_MAX_POINTS
+ * @param rule ILI_FILL_EVEN_ODD or ILI_FILL_NON_ZERO, how self-intersecting polygons are filled
+ * @param color 16-bit RGB565 color
+ * @return 1 if done, 0 if count is above ILI_POLYGON_MAX_POINTS (nothing is drawn)
+ */
+uint8_t ili_fill_polygon(const ili_point_t *points, uint16_t count, uint8_t rule, uint16_t color)
+{
+	if (count > ILI_POLYGON_MAX_POINTS)
+		return 0;
+	ILI_STATS_BEGIN(ILI_STATS_FILL_POLYGON);
+	_ili_fill_polygon(points, count, 0, rule, color);
+	ILI_STATS_END();
+	return 1;
+}
+
+
+/**
+ * Fill a triangle. Same pixel rule as ili_fill_polygon(), so triangles sharing an edge
+ * (e.g. a fan around a gauge center) never overlap.
+ * @param x0 column of the 1st vertex
+ * @param y0 row of the 1st vertex
+ * @param x1 column of the 2nd vertex
+ * @param y1 row of the 2nd vertex
+ * @param x2 column of the 3rd vertex
+ * @param y2 row of the 3rd vertex
+ * @param color 16-bit RGB565 color
+ */
+void ili_fill_triangle(uint16_t x0, uint16_t y0, uint16_t x1, uint16_t y1, uint16_t x2, uint16_t y2, uint16_t color)
+{
+	ili_point_t points[3] = {{x0, y0}, {x1, y1}, {x2, y2}};
+
+	ILI_STATS_BEGIN(ILI_STATS_FILL_TRIANGLE);
+	ili_fill_polygon(points, 3, ILI_FILL_EVEN_ODD, color);
+	ILI_STATS_END();
+}
+
+
+// cos(k * 22.5 deg) for k = 0 to 8, Q14. sin(k * 22.5 deg) is ili_arc_cos[|4 - k|].
+static const int16_t ili_arc_cos[9] = { 16384, 15137, 11585, 6270, 0, -6270, -11585, -15137, -16384 };
+
+
+/*
+ * Integer square root
+ * User need NOT call it
+ */
+static uint32_t _ili_isqrt(uint64_t v)
+{
+	uint64_t root = 0;
+	uint64_t bit = (uint64_t)1 << 62;
+
+	while (bit > v)
+		bit >>= 2;
+	while (bit)
+	{
+		if (v >= root + bit)
+		{
+			v -= root + bit;
+			root = (root >> 1) + bit;
+		}
+		else
+		{
+			root >>= 1;
+		}
+		bit >>= 2;
+	}
+	return (uint32_t)root;
+}
+
+
+/*
+ * n / d rounded to nearest, d > 0
+ * User need NOT call it
+ */
+static int32_t _ili_div_round(int32_t n, int32_t d)
+{
+	return (n >= 0) ? (n + d / 2) / d : -((-n + d / 2) / d);
+}
+
+
+/*
+ * Scale the direction (dx, dy) to length r: (tx, ty). A zero direction gives (r, 0).
+ * User need NOT call it
+ */
+static void _ili_line_vector(int32_t dx, int32_t dy, int32_t r, int32_t *tx, int32_t *ty)
+{
+	uint32_t len = _ili_isqrt((uint64_t)((int64_t)dx * dx) + (uint64_t)((int64_t)dy * dy));
+
+	if (len == 0)
+	{
+		*tx = r;
+		*ty = 0;
+		return;
+	}
+	*tx = _ili_div_round(dx * r, len);
+	*ty = _ili_div_round(dy * r, len);
+}
+
+
+/*
+ * Append the outline of a line end at (cx,cy) to `points`, from (cx,cy) + u to (cx,cy) - u.
+ * u is the half width across the line, t the half width along it, pointing away from the line.
+ * Returns the number of points: 2 for a butt or square cap, 9 for a round cap.
+ * User need NOT call it
+ */
+static uint8_t _ili_cap_points(ili_point_t *points, int32_t cx, int32_t cy, int32_t ux, int32_t uy, int32_t tx, int32_t ty, uint8_t cap)
+{
+	if (cap == ILI_CAP_ROUND)
+	{
+		// u rotated by 0 to -180 degrees in 22.5 degree steps
+		for (uint8_t k = 0; k <= 8; k++)
+		{
+			int32_t c = ili_arc_cos[k];
+			int32_t s = ili_arc_cos[(k > 4) ? k - 4 : 4 - k];
+			points[k].x = cx + ((ux * c + uy * s + 8192) >> 14);
+			points[k].y = cy + ((uy * c - ux * s + 8192) >> 14);
+		}
+		return 9;
+	}
+	if (cap != ILI_CAP_SQUARE)
+	{
+		tx = 0;
+		ty = 0;
+	}
+	points[0].x = cx + ux + tx;
+	points[0].y = cy + uy + ty;
+	points[1].x = cx - ux + tx;
+	points[1].y = cy - uy + ty;
+	return 2;
+}
+
+
+/*
+ * Fill a line segment from (x0,y0) to (x1,y1), given in 1/(1 << ILI_LINE_SUBPIXEL_SHIFT) pixels,
+ * `r` is half the width. The segment with both caps is one polygon, so every pixel is written once.
+ * A segment of zero length is a square or disc of width 2r (nothing for butt caps).
+ * User need NOT call it
+ */
+void _ili_fill_line_segment(int32_t x0, int32_t y0, int32_t x1, int32_t y1, int32_t r, uint8_t cap0, uint8_t cap1, uint16_t color)
+{
+	ili_point_t points[18];
+	int32_t tx, ty;
+	uint8_t n;
+
+	_ili_line_vector(x1 - x0, y1 - y0, r, &tx, &ty);
+	// Normal -ty, tx is on the left of the direction, seen on the screen (y down)
+	n = _ili_cap_points(points, x1, y1, -ty, tx, tx, ty, cap1);
+	n += _ili_cap_points(&points[n], x0, y0, ty, -tx, -tx, -ty, cap0);
+	_ili_fill_polygon(points, n, ILI_LINE_SUBPIXEL_SHIFT, ILI_FILL_NON_ZERO, color);
+}
+
+
+/*
+ * Outer side of the join of two thick line segments meeting at (x,y), from (x,y) + o1 to
+ * (x,y) + o2. o1 and o2 are the outer normals of the incoming and outgoing segment, (tx,ty) the
+ * incoming direction, all of length r. `part` 0 is the whole join, 1 the part up to its middle
+ * point and 2 the part from the middle point on. The middle point lies on the bisector of the
+ * turn, so the two parts meet exactly. Returns the number of points written, at most 9.
+ * User need NOT call it
+ */
+static uint8_t _ili_join_points(ili_point_t *points, int32_t x, int32_t y, int32_t o1x, int32_t o1y, int32_t o2x, int32_t o2y,
+		int32_t tx, int32_t ty, int32_t r, uint8_t join, uint8_t part)
+{
+	int32_t path[9][2];			// o1, round join steps, o2
+	uint8_t len = 0, n = 0;
+	int32_t mx, my;				// middle point
+	int64_t r2 = (int64_t)r * r;
+	int64_t k = r2 + (int64_t)o1x * o2x + (int64_t)o1y * o2y;
+	// Direction of rotation from o1 to o2: towards the incoming direction
+	int8_t dir = ((int64_t)o1x * ty - (int64_t)o1y * tx > 0) ? 1 : -1;
+	uint8_t miter = (join == ILI_JOIN_MITER && k > 0 && 2 * r2 <= ILI_MITER_LIMIT * ILI_MITER_LIMIT * k);
+
+	path[len][0] = o1x;
+	path[len++][1] = o1y;
+	if (join == ILI_JOIN_ROUND)
+	{
+		// o1 rotated in 22.5 degree steps as long as o2 is still ahead
+		for (uint8_t i = 1; i < 8; i++)
+		{
+			int32_t c = ili_arc_cos[i];
+			int32_t sn = dir * ili_arc_cos[(i > 4) ? i - 4 : 4 - i];
+			int32_t vx = (o1x * c - o1y * sn + 8192) >> 14;
+			int32_t vy = (o1x * sn + o1y * c + 8192) >> 14;
+			int64_t cross = dir * ((int64_t)vx * o2y - (int64_t)vy * o2x);
+			if (cross < 0 || (cross == 0 && (int64_t)vx * o2x + (int64_t)vy * o2y > 0))
+				break;
+			path[len][0] = vx;
+			path[len++][1] = vy;
+		}
+		_ili_line_vector(o1x + o2x, o1y + o2y, r, &mx, &my);
+	}
+	else if (miter)
+	{
+		/*
+		 * The miter tip is at (o1 + o2) * r^2 / (r^2 + o1.o2). Its distance from the joint is
+		 * r * sqrt(2 / (1 + cos)), limited to ILI_MITER_LIMIT * r, beyond that the join is beveled.
+		 */
+		mx = (int32_t)((o1x + o2x) * r2 / k);
+		my = (int32_t)((o1y + o2y) * r2 / k);
+	}
+	else
+	{
+		mx = (o1x + o2x) / 2;
+		my = (o1y + o2y) / 2;
+	}
+	path[len][0] = o2x;
+	path[len++][1] = o2y;
+
+	for (uint8_t i = 0; i < len; i++)
+	{
+		// Is the middle point still ahead of this point?
+		uint8_t before = (i == 0) || (i + 1 < len && dir * ((int64_t)path[i][0] * my - (int64_t)path[i][1] * mx) > 0);
+		if (part == 2 && i == 0)
+		{
+			points[n].x = x + mx;
+			points[n++].y = y + my;
+		}
+		if ((part == 0) || (part == 1 && before) || (part == 2 && !before))
+		{
+			points[n].x = x + path[i][0];
+			points[n++].y = y + path[i][1];
+		}
+		if ((part == 1 && !before) || (part == 0 && miter && i == 0))
+		{
+			points[n].x = x + mx;
+			points[n++].y = y + my;
+		}
+		if (part == 1 && !before)
+			break;
+	}
+	return n;
+}
+
+
+/**
+ * Draw a thick line as one filled polygon, centered on the pixels (x0,y0) and (x1,y1).
+ * Every pixel is written once.
+ * @param x0 start column address
+ * @param y0 start row address
+ * @param x1 end column address
+ * @param y1 end row address
+ * @param width width of the line in pixels
+ * @param cap ILI_CAP_BUTT (ends at the end points), ILI_CAP_SQUARE or ILI_CAP_ROUND (extend by half the width)
+ * @param color 16-bit RGB565 color
+ */
+void ili_draw_thick_line(uint16_t x0, uint16_t y0, uint16_t x1, uint16_t y1, uint8_t width, uint8_t cap, uint16_t color)
+{
+	int32_t one = 1 << ILI_LINE_SUBPIXEL_SHIFT;
+
+	ILI_STATS_BEGIN(ILI_STATS_DRAW_THICK_LINE);
+	_ili_fill_line_segment(x0 * one + one / 2, y0 * one + one / 2, x1 * one + one / 2, y1 * one + one / 2,
+			width * one / 2, cap, cap, color);
+	ILI_STATS_END();
+}
+
+
+/*
+ * Index of the first point after points[i] that differs from it, `count` if there is none
+ * User need NOT call it
+ */
+static uint16_t _ili_next_point(const ili_point_t *points, uint16_t count, uint16_t i)
+{
+	uint16_t j = i + 1;
+
+	while (j < count && points[j].x == points[i].x && points[j].y == points[i].y)
+		j++;
+	return j;
+}
+
+
+/*
+ * Close the outline of a polyline run: `left` holds the start and the left side, `right` the
+ * right side in line direction, which is appended backwards. Then fill it.
+ * User need NOT call it
+ */
+static void _ili_fill_polyline_run(ili_point_t *left, uint8_t n, const ili_point_t *right, uint8_t m, uint16_t color)
+{
+	while (m)
+		left[n++] = right[--m];
+	_ili_fill_polygon(left, n, ILI_LINE_SUBPIXEL_SHIFT, ILI_FILL_NON_ZERO, color);
+}
+
+
+/**
+ * Draw connected thick lines through `points`, centered on the pixels.
+ * The segments are filled as outlines with their joins, so no pixel is written twice.
+ * @param points vertices of the polyline
+ * @param count number of vertices
+ * @param width width of the lines in pixels
+ * @param cap ILI_CAP_BUTT, ILI_CAP_SQUARE or ILI_CAP_ROUND, for both ends of the polyline
+ * @param join ILI_JOIN_MITER (beveled beyond ILI_MITER_LIMIT), ILI_JOIN_BEVEL or ILI_JOIN_ROUND
+ * @param color 16-bit RGB565 color
+ */
+void ili_draw_polyline(const ili_point_t *points, uint16_t count, uint8_t width, uint8_t cap, uint8_t join, uint16_t color)
+{
+	int32_t one = 1 << ILI_LINE_SUBPIXEL_SHIFT;
+	int32_t r = width * one / 2;
+	/*
+	 * Consecutive segments are collected into a run that is filled as one outline with the
+	 * non-zero rule: the start (cap or cut) and the left side go to `left`, the right side to
+	 * `right`. At a turn the outer side gets the join, the inner side goes through the joint,
+	 * and overlapping parts are filled once. A run ends with a cut along the bisector of a turn,
+	 * from the middle of the join to where the inner edges cross, so the next run starts on
+	 * exactly that edge. Turns whose inner crossing is beyond half of a segment are not cut.
+	 */
+	ili_point_t left[ILI_POLYGON_MAX_POINTS];
+	ili_point_t right[ILI_POLYGON_MAX_POINTS];
+	ili_point_t wedge[10];
+	// Points a run may still need after a join: a round cap, or the first half of a join and the crossing
+	uint8_t tail = (cap == ILI_CAP_ROUND) ? 9 : 7;
+	uint8_t n = 0, m = 0;
+	uint16_t a, b, c;
+	int32_t tx, ty;
+
+	if (count < 2)
+		return;
+
+	ILI_STATS_BEGIN(ILI_STATS_DRAW_POLYLINE);
+	a = 0;
+	b = _ili_next_point(points, count, a);
+	if (b == count)
+	{
+		// All points are the same: a dot shaped by the caps
+		int32_t x = points[0].x * one + one / 2, y = points[0].y * one + one / 2;
+		_ili_fill_line_segment(x, y, x, y, r, cap, cap, color);
+		ILI_STATS_END();
+		return;
+	}
+
+	_ili_line_vector((points[b].x - points[a].x) * one, (points[b].y - points[a].y) * one, r, &tx, &ty);
+	n = _ili_cap_points(left, points[a].x * one + one / 2, points[a].y * one + one / 2, ty, -tx, -tx, -ty, cap);
+
+	while (1)
+	{
+		int32_t jx = points[b].x * one + one / 2;
+		int32_t jy = points[b].y * one + one / 2;
+
+		c = _ili_next_point(points, count, b);
+		if (c == count)
+		{
+			n += _ili_cap_points(&left[n], jx, jy, -ty, tx, tx, ty, cap);
+			_ili_fill_polyline_run(left, n, right, m, color);
+			break;
+		}
+
+		int32_t dax = points[b].x - points[a].x, day = points[b].y - points[a].y;
+		int32_t dbx = points[c].x - points[b].x, dby = points[c].y - points[b].y;
+		int32_t ux, uy;
+		_ili_line_vector(dbx * one, dby * one, r, &ux, &uy);
+		int64_t cross = (int64_t)dax * dby - (int64_t)day * dbx;
+		int64_t dot = (int64_t)dax * dbx + (int64_t)day * dby;
+
+		if (cross == 0 && dot > 0)
+		{
+			// Straight on: cut across the line
+			left[n].x = jx - ty;
+			left[n++].y = jy + tx;
+			left[n].x = jx + ty;
+			left[n++].y = jy - tx;
+			_ili_fill_polyline_run(left, n, right, m, color);
+			n = 0;
+			m = 0;
+			left[n].x = jx + uy;
+			left[n++].y = jy - ux;
+			left[n].x = jx - uy;
+			left[n++].y = jy + ux;
+		}
+		else
+		{
+			// Outer normals; the left normal is (-ty, tx)
+			uint8_t outer_left = (cross < 0);
+			int32_t o1x = outer_left ? -ty : ty, o1y = outer_left ? tx : -tx;
+			int32_t o2x = outer_left ? -uy : uy, o2y = outer_left ? ux : -ux;
+			ili_point_t *outer = outer_left ? left : right;
+			ili_point_t *inner = outer_left ? right : left;
+			uint8_t *outer_n = outer_left ? &n : &m;
+			uint8_t *inner_n = outer_left ? &m : &n;
+			uint8_t w;
+
+			// Where the inner edges cross: (x,y) - o1 + s * da, with s * (da x db) = (o1 - o2) x db
+			int32_t ex = 0, ey = 0;
+			uint8_t cut = 0;
+			if (cross != 0)
+			{
+				int64_t s = (int64_t)(o1x - o2x) * dby - (int64_t)(o1y - o2y) * dbx;
+				int32_t d = (int32_t)((cross > 0) ? cross : -cross);
+				if (cross < 0)
+					s = -s;
+				ex = -o1x + _ili_div_floor(2 * dax * s + d, 2 * d);
+				ey = -o1y + _ili_div_floor(2 * day * s + d, 2 * d);
+				cut = (-2 * ((int64_t)ex * dax + (int64_t)ey * day) <= ((int64_t)dax * dax + (int64_t)day * day) * one) &&
+						(2 * ((int64_t)ex * dbx + (int64_t)ey * dby) <= ((int64_t)dbx * dbx + (int64_t)dby * dby) * one);
+			}
+
+			if (cut)
+			{
+				// End the run on the bisector: left side, first half of the join, crossing, right side
+				w = _ili_join_points(wedge, jx, jy, o1x, o1y, o2x, o2y, tx, ty, r, join, 1);
+				if (!outer_left)
+				{
+					left[n].x = jx + ex;
+					left[n++].y = jy + ey;
+				}
+				for (uint8_t i = 0; i < w; i++)
+					left[n++] = wedge[outer_left ? i : w - 1 - i];
+				if (outer_left)
+				{
+					left[n].x = jx + ex;
+					left[n++].y = jy + ey;
+				}
+				_ili_fill_polyline_run(left, n, right, m, color);
+
+				// The next run starts on the same edge, from the right side to the left side
+				w = _ili_join_points(wedge, jx, jy, o1x, o1y, o2x, o2y, tx, ty, r, join, 2);
+				n = 0;
+				m = 0;
+				if (outer_left)
+				{
+					left[n].x = jx + ex;
+					left[n++].y = jy + ey;
+				}
+				for (uint8_t i = 0; i < w; i++)
+					left[n++] = wedge[outer_left ? i : w - 1 - i];
+				if (!outer_left)
+				{
+					left[n].x = jx + ex;
+					left[n++].y = jy + ey;
+				}
+			}
+			else
+			{
+				w = _ili_join_points(&wedge[1], jx, jy, o1x, o1y, o2x, o2y, tx, ty, r, join, 0);
+				if (n + m + w + 3 + tail <= ILI_POLYGON_MAX_POINTS)
+				{
+					// Sharp turn on short segments: the run goes on, the inner side through the joint
+					for (uint8_t i = 1; i <= w; i++)
+						outer[(*outer_n)++] = wedge[i];
+					inner[*inner_n].x = jx - o1x;
+					inner[(*inner_n)++].y = jy - o1y;
+					inner[*inner_n].x = jx;
+					inner[(*inner_n)++].y = jy;
+					inner[*inner_n].x = jx - o2x;
+					inner[(*inner_n)++].y = jy - o2y;
+				}
+				else
+				{
+					// No room left in the run: butt ends and the join on its own, they overlap on the inner side
+					left[n].x = jx - ty;
+					left[n++].y = jy + tx;
+					left[n].x = jx + ty;
+					left[n++].y = jy - tx;
+					_ili_fill_polyline_run(left, n, right, m, color);
+					wedge[0].x = jx;
+					wedge[0].y = jy;
+					_ili_fill_polygon(wedge, 1 + w, ILI_LINE_SUBPIXEL_SHIFT, ILI_FILL_NON_ZERO, color);
+					n = 0;
+					m = 0;
+					left[n].x = jx + uy;
+					left[n++].y = jy - ux;
+					left[n].x = jx - uy;
+					left[n++].y = jy + ux;
+				}
+			}
+		}
+		a = b;
+		b = c;
+		tx = ux;
+		ty = uy;
+	}
+	ILI_STATS_END();
+}
+
+
+// Anti-aliasing ramp of the current call: `color` over `bg` in ILI_AA_LEVELS steps, as bus bytes
+static uint8_t ili_aa_high[ILI_AA_LEVELS];
+static uint8_t ili_aa_low[ILI_AA_LEVELS];
+
+
+/*
+ * Fill the anti-aliasing ramp: level 0 is `bg`, level ILI_AA_LEVELS - 1 is `color`,
+ * each RGB565 channel interpolated linearly.
+ * User need NOT call it
+ */
+static void _ili_aa_ramp(uint16_t color, uint16_t bg)
+{
+	int32_t r = bg >> 11, g = (bg >> 5) & 0x3F, b = bg & 0x1F;
+	int32_t dr = (color >> 11) - r;
+	int32_t dg = ((color >> 5) & 0x3F) - g;
+	int32_t db = (color & 0x1F) - b;
+
+	for (uint8_t i = 0; i < ILI_AA_LEVELS; i++)
+	{
+		uint16_t c = ((r + dr * i / (ILI_AA_LEVELS - 1)) << 11) |
+				((g + dg * i / (ILI_AA_LEVELS - 1)) << 5) |
+				(b + db * i / (ILI_AA_LEVELS - 1));
+		ili_aa_high[i] = c >> 8;
+		ili_aa_low[i] = c;
+	}
+}
+
+
+/*
+ * Send a run of anti-aliased pixel pairs as one address window. Along the run (columns a1 to a2
+ * of row b, or rows a1 to a2 of column b when `vertical`) the inner pixel at b gets the level
+ * ILI_AA_LEVELS - 1 - level[i], the outer pixel at b + db (db is 1 or -1) gets level[i].
+ * With `reverse` level[] is read from the end. Clipped to the clip rectangle.
+ * User need NOT call it
+ */
+static void _ili_aa_run(int32_t a1, int32_t a2, int32_t b, int8_t db, uint8_t vertical, const uint8_t *level, uint8_t reverse)
+{
+	int32_t base = reverse ? a2 : a1;		// a of level[0]
+	int32_t b1 = (db > 0) ? b : b - 1;		// the pair in screen order
+	int32_t b2 = b1 + 1;
+
+	if (vertical ? !_ili_clip_area(&b1, &a1, &b2, &a2) : !_ili_clip_area(&a1, &b1, &a2, &b2))
+		return;
+
+	if (vertical)
+		ili_set_address_window(b1, a1, b2, a2);
+	else
+		ili_set_address_window(a1, b1, a2, b2);
+	ILI_STATS_ADD(pixel_bytes, (uint32_t)(a2 - a1 + 1) * (uint32_t)(b2 - b1 + 1) * 2);
+
+	ILI_DC_DAT;
+	if (vertical)
 	{
-		while(blocks--)
+		// Row by row, both pixels of the pair in each row
+		for (int32_t a = a1; a <= a2; a++)
 		{
-			// pass count = number of blocks / pixels per pass = 64 / 4
-			pass_count = 16;
-			while(pass_count--)
+			uint8_t l = level[reverse ? base - a : a - base];
+			for (int32_t side = b1; side <= b2; side++)
 			{
-				ILI_WR_STROBE; ILI_WR_STROBE; ILI_WR_STROBE; ILI_WR_STROBE; // 2
-				ILI_WR_STROBE; ILI_WR_STROBE; ILI_WR_STROBE; ILI_WR_STROBE; // 4
+				uint8_t lv = (side == b) ? ILI_AA_LEVELS - 1 - l : l;
+				ILI_WRITE_8BIT(ili_aa_high[lv]);
+				ILI_WRITE_8BIT(ili_aa_low[lv]);
 			}
 		}
-		// Fill any remaining pixels (1 to 64)
-		pass_count = len & 63;
-		while (pass_count--)
-		{
-			ILI_WR_STROBE; ILI_WR_STROBE;
-		}
 	}
-
-	// If higher and lower bytes are different, send those bytes
 	else
 	{
-		while(blocks--)
+		// One row of the pair after the other
+		for (int32_t side = b1; side <= b2; side++)
 		{
-			pass_count = 16;
-			while(pass_count--)
+			for (int32_t a = a1; a <= a2; a++)
 			{
-				ILI_WRITE_8BIT(color_high); ILI_WRITE_8BIT(color_low); 	ILI_WRITE_8BIT(color_high); ILI_WRITE_8BIT(color_low); //2
-				ILI_WRITE_8BIT(color_high); ILI_WRITE_8BIT(color_low); 	ILI_WRITE_8BIT(color_high); ILI_WRITE_8BIT(color_low); //4
+				uint8_t l = level[reverse ? base - a : a - base];
+				uint8_t lv = (side == b) ? ILI_AA_LEVELS - 1 - l : l;
+				ILI_WRITE_8BIT(ili_aa_high[lv]);
+				ILI_WRITE_8BIT(ili_aa_low[lv]);
 			}
 		}
-		pass_count = len & 63;
-		while (pass_count--)
-		{
-			// write here the remaining data
-			ILI_WRITE_8BIT(color_high); ILI_WRITE_8BIT(color_low);
-		}
 	}
 }
 
 
 /**
- * Fills a rectangular area with `color`.
- * Before filling, performs area bound checking
- * @param x Start col address
- * @param y Start row address
- * @param w Width of rectangle
- * @param h Height of rectangle
- * @param color 16-bit RGB565 color
+ * Draw an anti-aliased 1 pixel line (Xiaolin Wu) over a known, plain background.
+ * Every step covers two pixels across the line, blended between `color` and `bg` by a precomputed
+ * ramp, so nothing is read back. The steps of one pixel row (or column for steep lines) are sent
+ * as one address window.
+ * @param x0 start column address
+ * @param y0 start row address
+ * @param x1 end column address
+ * @param y1 end row address
+ * @param color 16-bit RGB565 color of the line
+ * @param bg 16-bit RGB565 color of the background under the line
  */
-void ili_fill_rect(uint16_t x, uint16_t y, uint16_t w, uint16_t h, uint16_t color)
+void ili_draw_line_aa(uint16_t x0, uint16_t y0, uint16_t x1, uint16_t y1, uint16_t color, uint16_t bg)
 {
-	if (x >= ili_tftwidth || y >= ili_tftheight || w == 0 || h == 0)
-		return;
-	if (x + w - 1 >= ili_tftwidth)
-		w = ili_tftwidth - x;
-	if (y + h - 1 >= ili_tftheight)
-		h = ili_tftheight - y;
-
-	ili_set_address_window(x, y, x + w - 1, y + h - 1);
-	ili_fill_color(color, (uint32_t)w * (uint32_t)h);
-}
+	uint8_t level[ILI_AA_RUN_MAX];
+	int32_t dx = x1 - x0;
+	int32_t dy = y1 - y0;
+	uint8_t steep = abs(dy) > abs(dx);
 
+	ILI_STATS_BEGIN(ILI_STATS_DRAW_LINE_AA);
+	if (dx == 0 || dy == 0)
+	{
+		// Nothing to blend
+		_ili_fill_area(x0 < x1 ? x0 : x1, y0 < y1 ? y0 : y1, x0 < x1 ? x1 : x0, y0 < y1 ? y1 : y0, color);
+		ILI_STATS_END();
+		return;
+	}
+	_ili_aa_ramp(color, bg);
+
+	// Step along the major axis a, the minor coordinate b is 16.16 fixed point
+	int32_t a = steep ? y0 : x0;
+	int32_t a_last = steep ? y1 : x1;
+	int32_t b = (steep ? x0 : y0) * 65536;
+	int32_t d = steep ? dx : dy;
+	int32_t len = steep ? dy : dx;
+	if (a > a_last)
+	{
+		a = a_last;
+		a_last = steep ? y0 : x0;
+		b = (steep ? x1 : y1) * 65536;
+		d = -d;
+		len = -len;
+	}
+	int32_t grad = d * 65536 / len;
 
-/*
- * Same as `ili_fill_rect()` but does not do bound checking, so it's slightly faster
- */
-void ili_fill_rect_fast(uint16_t x1, uint16_t y1, uint16_t w, uint16_t h, uint16_t color)
-{
-	ili_set_address_window(x1, y1, x1 + w - 1, y1 + h - 1);
-	ili_fill_color(color, (uint32_t)w * (uint32_t)h);
+	while (a <= a_last)
+	{
+		// Run of steps with the same pixel pair
+		int32_t start = a;
+		int32_t bf = b >> 16;
+		uint16_t n = 0;
+		while (a <= a_last && (b >> 16) == bf && n < ILI_AA_RUN_MAX)
+		{
+			level[n++] = ((b & 0xFFFF) * (ILI_AA_LEVELS - 1) + 0x8000) >> 16;
+			a++;
+			b += grad;
+		}
+		_ili_aa_run(start, a - 1, bf, 1, steep, level, 0);
+	}
+	ILI_STATS_END();
 }
 
 
 /**
- * Fill the entire display (screen) with `color`
- * @param color 16-bit RGB565 color
+ * Draw an anti-aliased 1 pixel circle (Xiaolin Wu) over a known, plain background.
+ * Same blending as ili_draw_line_aa(); the steps of one pixel row or column of each octant are
+ * sent as one address window.
+ * @param x0 center col address
+ * @param y0 center row address
+ * @param r radius
+ * @param color 16-bit RGB565 color of the circle
+ * @param bg 16-bit RGB565 color of the background under the circle
  */
-void ili_fill_screen(uint16_t color)
-{
-	ili_set_address_window(0, 0, ili_tftwidth - 1, ili_tftheight - 1);
-	ili_fill_color(color, (uint32_t)ili_tftwidth * (uint32_t)ili_tftheight);
-}
-
-
-/**
- * Draw a rectangle
-*/
-void ili_draw_rectangle(uint16_t x, uint16_t y, uint16_t w, uint16_t h, uint16_t color)
+void ili_draw_circle_aa(uint16_t x0, uint16_t y0, uint16_t r, uint16_t color, uint16_t bg)
 {
-	// Perform bound checking
-	if (x >= ili_tftwidth || y >= ili_tftheight || w == 0 || h == 0)
-		return;
-	if (x + w - 1 >= ili_tftwidth)
-		w = ili_tftwidth - x;
-	if (y + h - 1 >= ili_tftheight)
-		h = ili_tftheight - y;
+	uint8_t level[ILI_AA_RUN_MAX];
+	int64_t r2 = (int64_t)r * r;
+	int32_t x = 0;
 
-	_ili_draw_fast_h_line(x, y, x+w-1, 1, color);
-	_ili_draw_fast_h_line(x, y+h, x+w-1, 1, color);
-	_ili_draw_fast_v_line(x, y, y+h-1, 1, color);
-	_ili_draw_fast_v_line(x+w, y, y+h-1, 1, color);
+	ILI_STATS_BEGIN(ILI_STATS_DRAW_CIRCLE_AA);
+	_ili_aa_ramp(color, bg);
 
+	// One octant, x from 0 to r / sqrt(2); y = sqrt(r^2 - x^2) with 8 fraction bits
+	uint32_t y = _ili_isqrt((uint64_t)r2 << 16);
+	while (2 * (int64_t)x * x <= r2)
+	{
+		int32_t start = x;
+		int32_t yf = y >> 8;
+		uint16_t n = 0;
+		while (2 * (int64_t)x * x <= r2 && (int32_t)(y >> 8) == yf && n < ILI_AA_RUN_MAX)
+		{
+			level[n++] = ((y & 0xFF) * (ILI_AA_LEVELS - 1) + 0x80) >> 8;
+			x++;
+			y = _ili_isqrt((uint64_t)(r2 - (int64_t)x * x) << 16);
+		}
 
+		// Mirrored runs leave out x = 0, drawn by the unmirrored ones
+		int32_t end = x - 1;
+		int32_t skip = (start == 0) ? 1 : 0;
+		_ili_aa_run(x0 + start, x0 + end, y0 - yf, -1, 0, level, 0);
+		_ili_aa_run(x0 + start, x0 + end, y0 + yf, 1, 0, level, 0);
+		_ili_aa_run(y0 + start, y0 + end, x0 + yf, 1, 1, level, 0);
+		_ili_aa_run(y0 + start, y0 + end, x0 - yf, -1, 1, level, 0);
+		if (end >= start + skip)
+		{
+			_ili_aa_run(x0 - end, x0 - start - skip, y0 - yf, -1, 0, level + skip, 1);
+			_ili_aa_run(x0 - end, x0 - start - skip, y0 + yf, 1, 0, level + skip, 1);
+			_ili_aa_run(y0 - end, y0 - start - skip, x0 + yf, 1, 1, level + skip, 1);
+			_ili_aa_run(y0 - end, y0 - start - skip, x0 - yf, -1, 1, level + skip, 1);
+		}
+	}
+	ILI_STATS_END();
 }
 
 /*
  * Called by ili_draw_line().
+ * Run-slice Bresenham: the pixels of a shallow line are horizontal runs, one row each. The
+ * length of every run is computed from the decision variable with one division and the run is
+ * sent as one address window and one fill. Same pixels as plain Bresenham.
  * User need not call it
  */
 void _ili_plot_line_low(uint16_t x0, uint16_t y0, uint16_t x1, uint16_t y1, uint8_t width, uint16_t color)
 {
-	int16_t dx = x1 - x0;
-	int16_t dy = y1 - y0;
+	int32_t dx = x1 - x0;
+	int32_t dy = y1 - y0;
 	int8_t yi = 1;
-	uint8_t pixels_per_point = width * width;	//no of pixels making a point. if line width is 1, this var is 1. if 2, this var is 4 and so on
-	uint8_t color_high = (uint8_t)(color >> 8);
-	uint8_t color_low = (uint8_t)color;
 	if (dy < 0)
 	{
 		yi = -1;
 		dy = -dy;
 	}
 
-	int16_t D = 2*dy - dx;
+	int32_t D = 2*dy - dx;
 	uint16_t y = y0;
 	uint16_t x = x0;
 
 	while (x <= x1)
 	{
-		ili_set_address_window(x, y, x+width-1, y+width-1);
-		//Drawing all the pixels of a single point
+		// Bresenham plots at x and steps y once D > 0, D grows by 2*dy per pixel
+		int32_t run = (D > 0) ? 1 : (-D / (2*dy) + 2);
+		if (run > x1 - x + 1)
+			run = x1 - x + 1;
 
-		ILI_DC_DAT;
-		for (uint8_t pixel_cnt = 0; pixel_cnt < pixels_per_point; pixel_cnt++)
-		{
-			ILI_WRITE_8BIT(color_high);
-			ILI_WRITE_8BIT(color_low);
-		}
-		if (D > 0)
-		{
-			y = y + yi;
-			D = D - 2*dx;
-		}
-		D = D + 2*dy;
-		x++;
+		// The squares of a thick line merge into one rectangle per run
+		_ili_fill_area(x, y, x+run+width-2, y+width-1, color);
+
+		D += 2*dy*(run - 1) - 2*dx + 2*dy;
+		x += run;
+		y += yi;
 	}
 }
 
 
 /*
  * Called by ili_draw_line().
+ * Run-slice Bresenham for steep lines: vertical runs, one column each.
  * User need not call it
  */
 void _ili_plot_line_high(uint16_t x0, uint16_t y0, uint16_t x1, uint16_t y1, uint8_t width, uint16_t color)
 {
-	int16_t dx = x1 - x0;
-	int16_t dy = y1 - y0;
+	int32_t dx = x1 - x0;
+	int32_t dy = y1 - y0;
 	int8_t xi = 1;
-	uint8_t pixels_per_point = width * width;	//no of pixels making a point. if line width is 1, this var is 1. if 2, this var is 4 and so on
-	uint8_t color_high = (uint8_t)(color >> 8);
-	uint8_t color_low = (uint8_t)color;
-
 	if (dx < 0)
 	{
 		xi = -1;
 		dx = -dx;
 	}
 
-	int16_t D = 2*dx - dy;
+	int32_t D = 2*dx - dy;
 	uint16_t y = y0;
 	uint16_t x = x0;
 
 	while (y <= y1)
 	{
-		ili_set_address_window(x, y, x+width-1, y+width-1);
-		//Drawing all the pixels of a single point
+		int32_t run = (D > 0) ? 1 : (-D / (2*dx) + 2);
+		if (run > y1 - y + 1)
+			run = y1 - y + 1;
 
-		ILI_DC_DAT;
-		for (uint8_t pixel_cnt = 0; pixel_cnt < pixels_per_point; pixel_cnt++)
-		{
-			ILI_WRITE_8BIT(color_high);
-			ILI_WRITE_8BIT(color_low);
-		}
-		if (D > 0)
-		{
-			x = x + xi;
-			D = D - 2*dy;
-		}
-		D = D + 2*dx;
-		y++;
+		_ili_fill_area(x, y, x+width-1, y+run+width-2, color);
+
+		D += 2*dx*(run - 1) - 2*dy + 2*dx;
+		y += run;
+		x += xi;
 	}
 }
 
@@ -548,6 +3061,7 @@ void ili_draw_line(uint16_t x0, uint16_t y0, uint16_t x1, uint16_t y1, uint8_t w
 	* Brehensen's algorithm is used.
 	* Not necessarily start points has to be less than end points.
 	*/
+	ILI_STATS_BEGIN(ILI_STATS_DRAW_LINE);
 
 	if (x0 == x1)	//vertical line
 	{
@@ -558,6 +3072,14 @@ void ili_draw_line(uint16_t x0, uint16_t y0, uint16_t x1, uint16_t y1, uint8_t w
 		_ili_draw_fast_h_line(x0, y0, x1, width, color);
 	}
 
+	else if (width > 1)
+	{
+		// The pen square has its top left corner on the line: one polygon, square caps
+		int32_t one = 1 << ILI_LINE_SUBPIXEL_SHIFT;
+		int32_t c = width * one / 2;
+		_ili_fill_line_segment(x0 * one + c, y0 * one + c, x1 * one + c, y1 * one + c, c, ILI_CAP_SQUARE, ILI_CAP_SQUARE, color);
+	}
+
 	else
 	{
 		if (abs(y1 - y0) < abs(x1 - x0))
@@ -576,7 +3098,7 @@ void ili_draw_line(uint16_t x0, uint16_t y0, uint16_t x1, uint16_t y1, uint8_t w
 				_ili_plot_line_high(x0, y0, x1, y1, width, color) ;
 		}
 	}
-
+	ILI_STATS_END();
 }
 
 
@@ -590,10 +3112,9 @@ void _ili_draw_fast_h_line(uint16_t x0, uint16_t y0, uint16_t x1, uint8_t width,
 	* Draw a horizontal line very fast
 	*/
 	if (x0 < x1)
-		ili_set_address_window(x0, y0, x1, y0+width-1);	//as it's horizontal line, y1=y0.. must be.
+		_ili_fill_area(x0, y0, x1, y0+width-1, color);	//as it's horizontal line, y1=y0.. must be.
 	else
-		ili_set_address_window(x1, y0, x0, y0+width-1);	
-	ili_fill_color(color, (uint32_t)width * (uint32_t)abs(x1 - x0 + 1));
+		_ili_fill_area(x1, y0, x0, y0+width-1, color);
 }
 
 
@@ -607,12 +3128,9 @@ void _ili_draw_fast_v_line(uint16_t x0, uint16_t y0, uint16_t y1, uint8_t width,
 	* Draw a vertical line very fast
 	*/
 	if (y0 < y1)
-		ili_set_address_window(x0, y0, x0+width-1, y1);	//as it's vertical line, x1=x0.. must be.
+		_ili_fill_area(x0, y0, x0+width-1, y1, color);	//as it's vertical line, x1=x0.. must be.
 	else
-		ili_set_address_window(x0, y1, x0+width-1, y0);	
-	
-	
-	ili_fill_color(color, (uint32_t)width * (uint32_t)abs(y1 - y0 + 1));
+		_ili_fill_area(x0, y1, x0+width-1, y0, color);
 }
 
 
@@ -626,12 +3144,233 @@ void ili_draw_pixel(uint16_t x, uint16_t y, uint16_t color)
 	/*
 	* Why?: This function is mainly added in the driver so that  ui libraries can use it.
 	* example: LittlevGL requires user to supply a function that can draw pixel
+	* To flush a whole rendered area, use ili_write_pixels() instead.
 	*/
+	if (x < ili_clip_x1 || x > ili_clip_x2 || y < ili_clip_y1 || y > ili_clip_y2)
+		return;
+	ILI_STATS_BEGIN(ILI_STATS_DRAW_PIXEL);
 
 	ili_set_address_window(x, y, x, y);
+	ILI_STATS_ADD(pixel_bytes, 2);
 	ILI_DC_DAT;
 	ILI_WRITE_8BIT((uint8_t)(color >> 8));
 	ILI_WRITE_8BIT((uint8_t)color);
+	ILI_STATS_END();
+}
+
+
+/**
+ * Read a rectangular area of GRAM into `buf` (RAMRD).
+ * Pixels are stored row by row as RGB565, the same format the drawing functions take.
+ * The area must be on screen, otherwise nothing is read.
+ * @param x Start col address
+ * @param y Start row address
+ * @param w Width of the area
+ * @param h Height of the area
+ * @param buf Destination of w * h pixels
+ */
+void ili_read_rect(uint16_t x, uint16_t y, uint16_t w, uint16_t h, uint16_t *buf)
+{
+	if (w == 0 || h == 0 || x + w > ili_tftwidth || y + h > ili_tftheight)
+		return;
+
+	uint32_t len = (uint32_t)w * (uint32_t)h;
+	uint8_t r, g, b;
+
+	ILI_STATS_BEGIN(ILI_STATS_READ_RECT);
+	_ili_set_window_range(x, y, x + w - 1, y + h - 1);
+	_ili_write_command_8bit(ILI_RAMRD);
+	ILI_STATS_ADD(read_bytes, 1 + 3 * len);
+
+	ILI_DC_DAT;
+	ILI_DATA_INPUT();
+	// First read after RAMRD returns no valid data
+	ILI_READ_8BIT(r);
+	/*
+	* GRAM is read as 18-bit RGB666 even with the 16-bit pixel format:
+	* one byte per component, the 6 significant bits left aligned.
+	*/
+	while (len--)
+	{
+		ILI_READ_8BIT(r);
+		ILI_READ_8BIT(g);
+		ILI_READ_8BIT(b);
+		*buf++ = ((uint16_t)(r & 0xF8) << 8) | ((uint16_t)(g & 0xFC) << 3) | (b >> 3);
+	}
+	ILI_DATA_OUTPUT();
+	ILI_STATS_END();
+}
+
+
+/**
+ * Read the color of one pixel
+ * @param x col address
+ * @param y row address
+ * @return 16-bit RGB565 color, 0 if the pixel is off screen
+ */
+uint16_t ili_read_pixel(uint16_t x, uint16_t y)
+{
+	uint16_t color = 0;
+
+	ILI_STATS_BEGIN(ILI_STATS_READ_PIXEL);
+	ili_read_rect(x, y, 1, 1, &color);
+	ILI_STATS_END();
+	return color;
+}
+
+
+/*
+ * Write `len` RGB565 pixels from `pixels` into the current address window.
+ * Call ili_set_address_window() before calling this function.
+ * User need NOT call it
+ */
+void _ili_write_pixels(const uint16_t *pixels, uint32_t len)
+{
+	uint32_t blocks;
+	uint8_t pass_count;
+
+	ILI_STATS_ADD(pixel_bytes, 2 * len);
+	ILI_DC_DAT;
+#ifdef FSMC_PLATFORM
+	/*
+	* A word store is split into four byte writes, lowest address first. Two native-endian
+	* pixels are swapped into bus order (high byte first) with one REV16.
+	*/
+	volatile uint32_t *bus_word = (volatile uint32_t *)&ILI_FSMC_DATA;
+	if (len && ((uintptr_t)pixels & 2))
+	{
+		ILI_WRITE_8BIT((uint8_t)(*pixels >> 8)); ILI_WRITE_8BIT((uint8_t)*pixels);
+		pixels++;
+		len--;
+	}
+	const uint32_t *src = (const uint32_t *)pixels;
+	for (blocks = len >> 1; blocks; blocks--)
+	{
+		uint32_t pair = *src++;
+		*bus_word = ((pair >> 8) & 0x00FF00FF) | ((pair << 8) & 0xFF00FF00);
+	}
+	if (len & 1)
+	{
+		pixels = (const uint16_t *)src;
+		ILI_WRITE_8BIT((uint8_t)(*pixels >> 8)); ILI_WRITE_8BIT((uint8_t)*pixels);
+	}
+	(void)pass_count;
+#else
+	#define ILI_WRITE_PIXEL(p)	{ILI_WRITE_8BIT((uint8_t)((p) >> 8)); ILI_WRITE_8BIT((uint8_t)(p));}
+	blocks = len / 8;	// 8 pixels/block
+	while (blocks--)
+	{
+		ILI_WRITE_PIXEL(pixels[0]); ILI_WRITE_PIXEL(pixels[1]); ILI_WRITE_PIXEL(pixels[2]); ILI_WRITE_PIXEL(pixels[3]);
+		ILI_WRITE_PIXEL(pixels[4]); ILI_WRITE_PIXEL(pixels[5]); ILI_WRITE_PIXEL(pixels[6]); ILI_WRITE_PIXEL(pixels[7]);
+		pixels += 8;
+	}
+	pass_count = len & 7;
+	while (pass_count--)
+	{
+		ILI_WRITE_PIXEL(*pixels);
+		pixels++;
+	}
+	#undef ILI_WRITE_PIXEL
+#endif
+}
+
+
+/**
+ * Write a rendered area to the display, e.g. the flush callback of a UI library.
+ * @param x1 start column address
+ * @param y1 start row address
+ * @param x2 end column address
+ * @param y2 end row address
+ * @param buf (x2 - x1 + 1) * (y2 - y1 + 1) RGB565 pixels, row by row, native byte order
+ */
+void ili_write_pixels(uint16_t x1, uint16_t y1, uint16_t x2, uint16_t y2, const uint16_t *buf)
+{
+	uint16_t width = x2 - x1 + 1;
+	uint16_t col, row, cols, rows;
+
+	if (x2 < x1 || y2 < y1)
+		return;
+	ILI_STATS_BEGIN(ILI_STATS_WRITE_PIXELS);
+	if (_ili_clip_window(x1, y1, width, y2 - y1 + 1, &col, &row, &cols, &rows))
+	{
+		buf += (uint32_t)row * width + col;
+		if (cols == width)
+		{
+			_ili_write_pixels(buf, (uint32_t)cols * (uint32_t)rows);
+		}
+		else
+		{
+			for (uint16_t j = 0; j < rows; j++, buf += width)
+				_ili_write_pixels(buf, cols);
+		}
+	}
+	ILI_STATS_END();
+}
+
+
+/**
+ * Copy a rectangular area of the screen to another position (GRAM read back and rewritten).
+ * Overlapping areas are copied in the right order. Both areas must be on screen.
+ * @param src_x Source start col address
+ * @param src_y Source start row address
+ * @param dst_x Destination start col address
+ * @param dst_y Destination start row address
+ * @param w Width of the area
+ * @param h Height of the area
+ */
+void ili_copy_rect(uint16_t src_x, uint16_t src_y, uint16_t dst_x, uint16_t dst_y, uint16_t w, uint16_t h)
+{
+	static uint16_t buf[ILI_COPY_BUF_PIXELS];
+
+	if (w == 0 || h == 0)
+		return;
+	if (src_x + w > ili_tftwidth || src_y + h > ili_tftheight || dst_x + w > ili_tftwidth || dst_y + h > ili_tftheight)
+		return;
+	if (src_x == dst_x && src_y == dst_y)
+		return;
+
+	// Only the part of the destination inside the clip rectangle is written
+	int32_t x1 = dst_x, y1 = dst_y;
+	int32_t x2 = x1 + w - 1, y2 = y1 + h - 1;
+	if (!_ili_clip_area(&x1, &y1, &x2, &y2))
+		return;
+	src_x += x1 - dst_x;
+	src_y += y1 - dst_y;
+	dst_x = x1;
+	dst_y = y1;
+	w = x2 - x1 + 1;
+	h = y2 - y1 + 1;
+	ILI_STATS_BEGIN(ILI_STATS_COPY_RECT);
+
+	/*
+	* Every strip is read completely before it is written, so only the order of the strips matters:
+	* moving down, rows are copied bottom to top; moving right, pieces of a row right to left.
+	* Then no strip overwrites source pixels that are still to be copied.
+	*/
+	uint16_t rows = (w <= ILI_COPY_BUF_PIXELS) ? ILI_COPY_BUF_PIXELS / w : 1;
+	uint16_t piece = (w <= ILI_COPY_BUF_PIXELS) ? w : ILI_COPY_BUF_PIXELS;
+	uint8_t bottom_up = dst_y > src_y;
+	uint8_t right_to_left = dst_x > src_x;
+
+	for (uint16_t done_rows = 0; done_rows < h; )
+	{
+		uint16_t n_rows = (h - done_rows < rows) ? h - done_rows : rows;
+		uint16_t row = bottom_up ? h - done_rows - n_rows : done_rows;
+
+		for (uint16_t done_cols = 0; done_cols < w; )
+		{
+			uint16_t n_cols = (w - done_cols < piece) ? w - done_cols : piece;
+			uint16_t col = right_to_left ? w - done_cols - n_cols : done_cols;
+
+			ili_read_rect(src_x + col, src_y + row, n_cols, n_rows, buf);
+			ili_set_address_window(dst_x + col, dst_y + row, dst_x + col + n_cols - 1, dst_y + row + n_rows - 1);
+			_ili_write_pixels(buf, (uint32_t)n_cols * n_rows);
+
+			done_cols += n_cols;
+		}
+		done_rows += n_rows;
+	}
+	ILI_STATS_END();
 }
 
 
@@ -656,8 +3395,19 @@ void ili_rotate_display(uint8_t rotation)
 #elif DSO138_PLATFORM
     uint16_t new_height = 320;
     uint16_t new_width = 240;
+#elif FSMC_PLATFORM
+    uint16_t new_height = 320;
+    uint16_t new_width = 240;
+#elif SIMULATOR_PLATFORM
+    uint16_t new_height = ILI_SIM_GRAM_HEIGHT;
+    uint16_t new_width = ILI_SIM_GRAM_WIDTH;
 #endif
 
+	ILI_STATS_BEGIN(ILI_STATS_ROTATE_DISPLAY);
+	ILI_DMA_WAIT();
+	// Ranges are interpreted differently after MADCTL changes, start over
+	ili_invalidate_address_window();
+
 	switch (rotation)
 	{
 		case 0:
@@ -685,8 +3435,211 @@ void ili_rotate_display(uint8_t rotation)
 			ili_tftwidth = new_height;
 			break;
 	}
+	ili_rotation = rotation;
+	// Clip rectangles are in the coordinates of the old rotation
+	ili_clip_reset();
+	ILI_STATS_END();
+}
+
+
+/*
+ * Rotation 2 and 3 mirror the scroll axis (MY in rotation 2, MX with MV in rotation 3),
+ * so the gate lines run from the end of the logical axis to its start.
+ * User need NOT call it
+ */
+static uint8_t _ili_scroll_reversed(void)
+{
+	return ili_rotation == 2 || ili_rotation == 3;
+}
+
+
+/*
+ * Current scroll offset in logical line order
+ * User need NOT call it
+ */
+static uint16_t _ili_scroll_offset(void)
+{
+	if (ili_scroll_vsa == 0)
+		return 0;
+	uint16_t shift = ili_scroll_vsp - ili_scroll_tfa;
+	return _ili_scroll_reversed() ? (ili_scroll_vsa - shift) % ili_scroll_vsa : shift;
+}
+
+
+/**
+ * Define the hardware scrolling area. Lines in the fixed areas don't move.
+ * `top_fixed` and `bottom_fixed` are counted along the scroll axis in the current rotation:
+ * top and bottom in rotation 0 and 2, left and right in rotation 1 and 3.
+ * The scroll position is set back to 0. ili_scroll_define(0, 0) scrolls the whole screen.
+ * @param top_fixed number of lines fixed at the start of the scroll axis
+ * @param bottom_fixed number of lines fixed at the end of the scroll axis
+ */
+void ili_scroll_define(uint16_t top_fixed, uint16_t bottom_fixed)
+{
+	if (top_fixed + bottom_fixed > ILI_SCROLL_LINES)
+		return;
+	ILI_STATS_BEGIN(ILI_STATS_SCROLL_DEFINE);
+	ILI_DMA_WAIT();
+
+	if (_ili_scroll_reversed())
+	{
+		ili_scroll_tfa = bottom_fixed;
+		ili_scroll_bfa = top_fixed;
+	}
+	else
+	{
+		ili_scroll_tfa = top_fixed;
+		ili_scroll_bfa = bottom_fixed;
+	}
+	ili_scroll_vsa = ILI_SCROLL_LINES - top_fixed - bottom_fixed;
+	ili_scroll_vsp = ili_scroll_tfa;
+
+	_ili_write_command_8bit(ILI_VSCRDEF);
+	_ili_write_data_16bit(ili_scroll_tfa);
+	_ili_write_data_16bit(ili_scroll_vsa);
+	_ili_write_data_16bit(ili_scroll_bfa);
+
+	_ili_write_command_8bit(ILI_VSCRSADD);
+	_ili_write_data_16bit(ili_scroll_vsp);
+	ILI_STATS_END();
+}
+
+
+/**
+ * Set the scroll position: the scroll area shows its content starting at line `offset`.
+ * Only sends VSCRSADD, GRAM is not touched.
+ * @param offset content line (0 to scroll area height - 1) shown first in the scroll area
+ */
+void ili_scroll_to(uint16_t offset)
+{
+	if (ili_scroll_vsa == 0)
+		return;
+	ILI_STATS_BEGIN(ILI_STATS_SCROLL);
+	ILI_DMA_WAIT();
+
+	offset %= ili_scroll_vsa;
+	// Mirrored axis: moving the content forward is moving the start line backwards
+	if (_ili_scroll_reversed())
+		offset = (ili_scroll_vsa - offset) % ili_scroll_vsa;
+	ili_scroll_vsp = ili_scroll_tfa + offset;
+
+	_ili_write_command_8bit(ILI_VSCRSADD);
+	_ili_write_data_16bit(ili_scroll_vsp);
+	ILI_STATS_END();
+}
+
+
+/**
+ * Move the content of the scroll area by `lines` towards the start of the scroll axis
+ * (up in rotation 0 and 2, left in rotation 1 and 3). Negative values move it back.
+ * The lines exposed at the other end still show old content, redraw them using ili_scroll_line().
+ * @param lines number of lines to scroll
+ */
+void ili_scroll(int16_t lines)
+{
+	if (ili_scroll_vsa == 0)
+		return;
+	ILI_STATS_BEGIN(ILI_STATS_SCROLL);
+	int32_t offset = ((int32_t)_ili_scroll_offset() + lines) % ili_scroll_vsa;
+	if (offset < 0)
+		offset += ili_scroll_vsa;
+	ili_scroll_to(offset);
+	ILI_STATS_END();
+}
+
+
+/**
+ * Translate a position on the scroll axis as seen on screen to the coordinate to draw at.
+ * Positions in the fixed areas are returned unchanged.
+ * Consecutive screen lines stay consecutive except where the scroll area wraps around.
+ * @param line y in rotation 0 and 2, x in rotation 1 and 3
+ * @return coordinate to pass to the drawing functions
+ */
+uint16_t ili_scroll_line(uint16_t line)
+{
+	uint16_t top = _ili_scroll_reversed() ? ili_scroll_bfa : ili_scroll_tfa;
+
+	if (line < top || line >= top + ili_scroll_vsa)
+		return line;
+	return top + (line - top + _ili_scroll_offset()) % ili_scroll_vsa;
+}
+
+/*
+ * Init sequence, replayed by _ili_send_init_table(). Each entry is:
+ * command, number of parameters (| ILI_INIT_DELAY if a delay follows), parameters, [delay in ms]
+ */
+#define ILI_INIT_DELAY	0x80
+
+static const uint8_t ili_init_table[] = {
+	0xEF, 3, 0x03, 0x80, 0x02,
+	0xCF, 3, 0x00, 0xC1, 0x30,
+	0xED, 4, 0x64, 0x03, 0x12, 0x81,
+	0xE8, 3, 0x85, 0x00, 0x78,
+	0xCB, 5, 0x39, 0x2C, 0x00, 0x34, 0x02,
+	0xF7, 1, 0x20,
+	0xEA, 2, 0x00, 0x00,
+	ILI_PWCTR1, 1, 0x23,						//Power control, VRH[5:0]
+	ILI_PWCTR2, 1, 0x10,						//Power control, SAP[2:0];BT[3:0]
+	ILI_VMCTR1, 2, 0x3e, 0x28,					//VCM control
+	ILI_VMCTR2, 1, 0x86,						//VCM control2
+	ILI_MADCTL, 1, 0x40,						//Memory Access Control, rotation 0 (landscape mode)
+	ILI_PIXFMT, 1, 0x55,
+	ILI_FRMCTR1, 2, 0x00, 0x13,					//0x18 79Hz, 0x1B default 70Hz, 0x13 100Hz
+	ILI_DFUNCTR, 3, 0x08, 0x82, 0x27,			//Display Function Control
+	0xF2, 1, 0x00,								//3Gamma Function Disable
+	ILI_GAMMASET, 1, 0x01,						//Gamma curve selected
+	ILI_GMCTRP1, 15, 0x0F, 0x31, 0x2B, 0x0C, 0x0E, 0x08, 0x4E, 0xF1, 0x37, 0x07, 0x10, 0x03, 0x0E, 0x09, 0x00,	//Set Gamma
+	ILI_GMCTRN1, 15, 0x00, 0x0E, 0x14, 0x03, 0x11, 0x07, 0x31, 0xC1, 0x48, 0x08, 0x0F, 0x0C, 0x31, 0x36, 0x0F,	//Set Gamma
+	ILI_TEON, 1, 0x00,							//Tearing effect output on, V-blank only
+	ILI_SLPOUT, 0 | ILI_INIT_DELAY, 5,			//Exit Sleep, 5ms before the next command
+	ILI_DISPON, 0,								//Display on
+};
+
+
+/*
+ * Busy wait `ms` milliseconds on the DWT cycle counter, scaled with rcc_ahb_frequency.
+ * No wait on the simulator.
+ * User need NOT call it
+ */
+static void _ili_delay_ms(uint16_t ms)
+{
+#ifdef SIMULATOR_PLATFORM
+	(void)ms;
+#else
+	uint32_t cycles_per_ms = rcc_ahb_frequency / 1000;
+
+	dwt_enable_cycle_counter();
+	while (ms--)
+	{
+		uint32_t start = DWT_CYCCNT;
+		while (DWT_CYCCNT - start < cycles_per_ms);
+	}
+#endif
+}
+
+
+/*
+ * Send a command table (format of ili_init_table) to the display
+ * User need NOT call it
+ */
+static void _ili_send_init_table(const uint8_t *table, uint16_t len)
+{
+	const uint8_t *end = table + len;
+
+	while (table < end)
+	{
+		uint8_t cmd = *table++;
+		uint8_t count = *table++;
+
+		_ili_write_command_8bit(cmd);
+		for (uint8_t i = 0; i < (count & ~ILI_INIT_DELAY); i++)
+			_ili_write_data_8bit(*table++);
+		if (count & ILI_INIT_DELAY)
+			_ili_delay_ms(*table++);
+	}
 }
 
+
 /**
  * Initialize the display driver
  */
@@ -696,123 +3649,36 @@ void ili_init()
 	ILI_CONFIG_GPIO_CLOCK();
 	// Configure gpio output dir and mode
 	ILI_CONFIG_GPIO();
+#ifdef ILI_USE_DMA
+	_ili_dma_init();
+#endif
+#ifdef ILI_USE_TE
+	_ili_te_init();
+#endif
+#ifdef ILI_USE_STATS
+	ili_stats_reset();
+#endif
+	ILI_STATS_BEGIN(ILI_STATS_INIT);
 
 	ILI_CS_ACTIVE;
 
 	ILI_RST_IDLE;
 	ILI_RST_ACTIVE;
+	_ili_delay_ms(1);		// RESX low for at least 10us
 	ILI_RST_IDLE;
-
-	// Approx 10ms delay at 128MHz clock
-	for (uint32_t i = 0; i < 2000000; i++)
-		__asm__("nop");
-
-	_ili_write_command_8bit(0xEF);
-	_ili_write_data_8bit(0x03);
-	_ili_write_data_8bit(0x80);
-	_ili_write_data_8bit(0x02);
-
-	_ili_write_command_8bit(0xCF);
-	_ili_write_data_8bit(0x00);
-	_ili_write_data_8bit(0XC1);
-	_ili_write_data_8bit(0X30);
-
-	_ili_write_command_8bit(0xED);
-	_ili_write_data_8bit(0x64);
-	_ili_write_data_8bit(0x03);
-	_ili_write_data_8bit(0X12);
-	_ili_write_data_8bit(0X81);
-
-	_ili_write_command_8bit(0xE8);
-	_ili_write_data_8bit(0x85);
-	_ili_write_data_8bit(0x00);
-	_ili_write_data_8bit(0x78);
-
-	_ili_write_command_8bit(0xCB);
-	_ili_write_data_8bit(0x39);
-	_ili_write_data_8bit(0x2C);
-	_ili_write_data_8bit(0x00);
-	_ili_write_data_8bit(0x34);
-	_ili_write_data_8bit(0x02);
-
-	_ili_write_command_8bit(0xF7);
-	_ili_write_data_8bit(0x20);
-
-	_ili_write_command_8bit(0xEA);
-	_ili_write_data_8bit(0x00);
-	_ili_write_data_8bit(0x00);
-
-	_ili_write_command_8bit(ILI_PWCTR1);    //Power control
-	_ili_write_data_8bit(0x23);   //VRH[5:0]
-
-	_ili_write_command_8bit(ILI_PWCTR2);    //Power control
-	_ili_write_data_8bit(0x10);   //SAP[2:0];BT[3:0]
-
-	_ili_write_command_8bit(ILI_VMCTR1);    //VCM control
-	_ili_write_data_8bit(0x3e);
-	_ili_write_data_8bit(0x28);
-
-	_ili_write_command_8bit(ILI_VMCTR2);    //VCM control2
-	_ili_write_data_8bit(0x86);  //--
-
-	_ili_write_command_8bit(ILI_MADCTL);    // Memory Access Control
-	_ili_write_data_8bit(0x40); // Rotation 0 (landscape mode)
-
-	_ili_write_command_8bit(ILI_PIXFMT);
-	_ili_write_data_8bit(0x55);
-
-	_ili_write_command_8bit(ILI_FRMCTR1);
-	_ili_write_data_8bit(0x00);
-	_ili_write_data_8bit(0x13); // 0x18 79Hz, 0x1B default 70Hz, 0x13 100Hz
-
-	_ili_write_command_8bit(ILI_DFUNCTR);    // Display Function Control
-	_ili_write_data_8bit(0x08);
-	_ili_write_data_8bit(0x82);
-	_ili_write_data_8bit(0x27);
-
-	_ili_write_command_8bit(0xF2);    // 3Gamma Function Disable
-	_ili_write_data_8bit(0x00);
-
-	_ili_write_command_8bit(ILI_GAMMASET);    //Gamma curve selected
-	_ili_write_data_8bit(0x01);
-
-	_ili_write_command_8bit(ILI_GMCTRP1);    //Set Gamma
-	_ili_write_data_8bit(0x0F);
-	_ili_write_data_8bit(0x31);
-	_ili_write_data_8bit(0x2B);
-	_ili_write_data_8bit(0x0C);
-	_ili_write_data_8bit(0x0E);
-	_ili_write_data_8bit(0x08);
-	_ili_write_data_8bit(0x4E);
-	_ili_write_data_8bit(0xF1);
-	_ili_write_data_8bit(0x37);
-	_ili_write_data_8bit(0x07);
-	_ili_write_data_8bit(0x10);
-	_ili_write_data_8bit(0x03);
-	_ili_write_data_8bit(0x0E);
-	_ili_write_data_8bit(0x09);
-	_ili_write_data_8bit(0x00);
-
-	_ili_write_command_8bit(ILI_GMCTRN1);    //Set Gamma
-	_ili_write_data_8bit(0x00);
-	_ili_write_data_8bit(0x0E);
-	_ili_write_data_8bit(0x14);
-	_ili_write_data_8bit(0x03);
-	_ili_write_data_8bit(0x11);
-	_ili_write_data_8bit(0x07);
-	_ili_write_data_8bit(0x31);
-	_ili_write_data_8bit(0xC1);
-	_ili_write_data_8bit(0x48);
-	_ili_write_data_8bit(0x08);
-	_ili_write_data_8bit(0x0F);
-	_ili_write_data_8bit(0x0C);
-	_ili_write_data_8bit(0x31);
-	_ili_write_data_8bit(0x36);
-	_ili_write_data_8bit(0x0F);
-
-	_ili_write_command_8bit(ILI_SLPOUT);    //Exit Sleep
-	//delay 150ms if display output is inaccurate
-
-	_ili_write_command_8bit(ILI_DISPON);    //Display on
-	//delay 150ms if display output is inaccurate
+	ili_invalidate_address_window();
+	// Hardware reset puts the scrolling area and MADCTL back to their defaults
+	ili_rotation = 0;
+	ili_clip_reset();
+	ili_scroll_tfa = 0;
+	ili_scroll_vsa = ILI_SCROLL_LINES;
+	ili_scroll_bfa = 0;
+	ili_scroll_vsp = 0;
+
+	// RESX high to SLPOUT: 120ms if the reset hit a running (sleep out) display, 5ms after power on
+	_ili_delay_ms(120);
+
+	_ili_send_init_table(ili_init_table, sizeof(ili_init_table));
+	ili_te_line = 0;
+	ILI_STATS_END();
 }
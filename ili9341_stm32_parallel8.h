@@ -23,8 +23,37 @@ SOFTWARE.
 */
 
 #include "fonts/bitmap_typedefs.h"
+#ifdef SIMULATOR_PLATFORM
+#include "ili9341_sim.h"
+#else
 #include <libopencm3/stm32/gpio.h>
 #include <libopencm3/stm32/rcc.h>
+#endif
+#ifdef FSMC_PLATFORM
+#include <libopencm3/stm32/fsmc.h>
+#endif
+
+// DMA streaming paces GPIO writes with a timer. The simulator always uses the bit-banged path
+// and the FSMC generates the bus timing in hardware, so it's not needed there.
+#if defined(SIMULATOR_PLATFORM) || defined(FSMC_PLATFORM)
+#undef ILI_USE_DMA
+#endif
+// The simulator has no TE pin, ili_te_wait() polls the scanline there
+#ifdef SIMULATOR_PLATFORM
+#undef ILI_USE_TE
+#endif
+#ifndef SIMULATOR_PLATFORM
+#include <libopencm3/cm3/dwt.h>
+#endif
+#ifdef ILI_USE_DMA
+#include <libopencm3/stm32/dma.h>
+#include <libopencm3/stm32/timer.h>
+#include <libopencm3/cm3/nvic.h>
+#endif
+#ifdef ILI_USE_TE
+#include <libopencm3/stm32/exti.h>
+#include <libopencm3/cm3/nvic.h>
+#endif
 
 #ifndef INC_ILI9341_STM32_PARALLEL8_H_
 #define INC_ILI9341_STM32_PARALLEL8_H_
@@ -57,6 +86,12 @@ SOFTWARE.
 #define ILI_RAMRD   0x2E
 
 #define ILI_PTLAR   0x30
+#define ILI_VSCRDEF 0x33
+#define ILI_TEOFF   0x34
+#define ILI_TEON    0x35
+#define ILI_VSCRSADD 0x37
+#define ILI_TESCANLINE 0x44
+#define ILI_GETSCANLINE 0x45
 #define ILI_MADCTL  0x36
 #define ILI_PIXFMT  0x3A
 
@@ -104,7 +139,7 @@ SOFTWARE.
 	((uint16_t)(G >> 2) << ILI_G_POS_BGR) | \
 	((uint16_t)(B >> 3) << ILI_B_POS_BGR))
 
-#ifdef USER_DEFAULT_PLATFORM
+#if defined(USER_DEFAULT_PLATFORM) || defined(SIMULATOR_PLATFORM) || defined(FSMC_PLATFORM)
     // Color definitions
     #define ILI_COLOR_BLACK       ILI_RGB(0,     0,   0)
     #define ILI_COLOR_NAVY        ILI_RGB(0,     0, 123)
@@ -183,6 +218,7 @@ SOFTWARE.
 	#define ILI_DC			GPIO5
 	#define ILI_WR			GPIO4
 	#define ILI_RD			GPIO3
+	#define ILI_PORT_WR		ILI_PORT_CTRL
 	#define JTAG_REMAPPING_MODE AFIO_MAPR_SWJ_CFG_FULL_SWJ_NO_JNTRST /* See below */
 
 #elif DSO138_PLATFORM
@@ -202,7 +238,55 @@ SOFTWARE.
 	#define ILI_CS			GPIO13
 	#define ILI_DC			GPIO14
 	#define ILI_WR			GPIO15
+	#define ILI_PORT_WR		ILI_PORT_CTRL_C
 	#define JTAG_REMAPPING_MODE AFIO_MAPR_SWJ_CFG_JTAG_OFF_SW_OFF /* See below */
+
+#elif FSMC_PLATFORM
+	/*
+	* STM32F103xC/D/E with FSMC, NOR/SRAM bank 1 (NE1), 8-bit data.
+	* The FSMC generates CS, WR and RD, and D/C follows address line
+	* ILI_FSMC_DC_ADDR_BIT: commands are written to ILI_FSMC_CMD, data to ILI_FSMC_DATA.
+	* Pin mapping:
+	* ILI9341				STM32
+	* ---------------------------
+	* 		--Data--
+	* DB10					PD14 (FSMC_D0)
+	* DB11					PD15 (FSMC_D1)
+	* DB12					PD0  (FSMC_D2)
+	* DB13					PD1  (FSMC_D3)
+	* DB14					PE7  (FSMC_D4)
+	* ..					..
+	* DB17					PE10 (FSMC_D7)
+	*
+	*		--Control--
+	* RESETn				PD13 (GPIO)
+	* CSn					PD7  (FSMC_NE1)
+	* D/Cn					PD11 (FSMC_A16)
+	* WRn					PD5  (FSMC_NWE)
+	* RDn					PD4  (FSMC_NOE)
+	*/
+	#define ILI_PORT_CTRL	GPIOD
+	#define ILI_RST			GPIO13
+	#define ILI_FSMC_DC_ADDR_BIT	16		// FSMC_A16
+
+	/*
+	* Bus timing in HCLK cycles. Write: ADDSET is the WR high time, DATAST the WR low time.
+	* The defaults meet the ILI9341 write cycle (66ns) at 72MHz. Reading GRAM is much
+	* slower (450ns cycle), so reads use their own timing (extended mode).
+	*/
+	#define ILI_FSMC_ADDSET			2
+	#define ILI_FSMC_DATAST			3
+	#define ILI_FSMC_READ_ADDSET	15
+	#define ILI_FSMC_READ_DATAST	30
+
+	#define ILI_FSMC_CMD	(*(volatile uint8_t *)(FSMC_BANK1_BASE))
+	#define ILI_FSMC_DATA	(*(volatile uint8_t *)(FSMC_BANK1_BASE + (1UL << ILI_FSMC_DC_ADDR_BIT)))
+
+#elif SIMULATOR_PLATFORM
+	/*
+	* No pins. The bus macros drive the ILI9341 model in simulator/ili9341_sim.c,
+	* so the driver can be run and measured on the host.
+	*/
 #endif
 /*
 Possible values of JTAG_REMAPPING_MODE:
@@ -241,13 +325,86 @@ AFIO_MAPR_SWJ_CFG_JTAG_OFF_SW_OFF: JTAG-DP disabled and SW-DP disabled
 	#define ILI_CS_IDLE			GPIO_BSRR(ILI_PORT_CTRL_C) = ILI_CS
 	#define ILI_RST_ACTIVE		GPIO_BRR(ILI_PORT_CTRL_B) = ILI_RST
 	#define ILI_RST_IDLE		GPIO_BSRR(ILI_PORT_CTRL_B) = ILI_RST
+#elif SIMULATOR_PLATFORM
+	#define ILI_RD_ACTIVE		ili_sim_pin_clear(ILI_SIM_PIN_RD)
+	#define ILI_RD_IDLE			ili_sim_pin_set(ILI_SIM_PIN_RD)
+	#define ILI_WR_ACTIVE		ili_sim_pin_clear(ILI_SIM_PIN_WR)
+	#define ILI_WR_IDLE			ili_sim_pin_set(ILI_SIM_PIN_WR)
+	#define ILI_DC_CMD			ili_sim_pin_clear(ILI_SIM_PIN_DC)
+	#define ILI_DC_DAT			ili_sim_pin_set(ILI_SIM_PIN_DC)
+	#define ILI_CS_ACTIVE		ili_sim_pin_clear(ILI_SIM_PIN_CS)
+	#define ILI_CS_IDLE			ili_sim_pin_set(ILI_SIM_PIN_CS)
+	#define ILI_RST_ACTIVE		ili_sim_pin_clear(ILI_SIM_PIN_RST)
+	#define ILI_RST_IDLE		ili_sim_pin_set(ILI_SIM_PIN_RST)
+#elif FSMC_PLATFORM
+	/*
+	 * WR, RD and CS are generated by the FSMC. D/C is an address line: commands are
+	 * written to ILI_FSMC_CMD by _ili_write_command_8bit(), everything else is data.
+	 */
+	#define ILI_RD_ACTIVE
+	#define ILI_RD_IDLE
+	#define ILI_WR_ACTIVE
+	#define ILI_WR_IDLE
+	#define ILI_DC_CMD
+	#define ILI_DC_DAT
+	#define ILI_CS_ACTIVE
+	#define ILI_CS_IDLE
+	#define ILI_RST_ACTIVE		GPIO_BRR(ILI_PORT_CTRL) = ILI_RST
+	#define ILI_RST_IDLE		GPIO_BSRR(ILI_PORT_CTRL) = ILI_RST
 #endif
 
 #define ILI_WR_STROBE		{ILI_WR_ACTIVE; ILI_WR_IDLE;}
 #define ILI_RD_STROBE		{ILI_RD_ACTIVE; ILI_RD_IDLE;}
 
-#define ILI_WRITE_8BIT(d)	{GPIO_BSRR(ILI_PORT_DATA) = (uint32_t)(0x00FF0000 | ((d) & 0xFF)); ILI_WR_STROBE;}
-#define ILI_READ_8BIT(d)	{d = (uint8_t)(GPIO_IDR(ILI_PORT_DATA) & 0x00FF;}
+/*
+ * ILI_READ_8BIT(d) is a complete read cycle: RD low, wait for the data, sample it into d, RD high.
+ * The data pins must be inputs, see ILI_DATA_INPUT() / ILI_DATA_OUTPUT().
+ * GRAM reads need RD low for at least 355ns (tRDLFM), RD high for at least 90ns (tRDHFM)
+ * and a whole read cycle of at least 450ns (tRCFM). The GPIO path waits ILI_READ_LOW_NS after
+ * RD goes low and ILI_READ_HIGH_NS after it goes high, counted with DWT_CYCCNT at
+ * rcc_ahb_frequency, so the timing holds at any clock. ili_init() starts the cycle counter.
+ * Raise them for long wires.
+ */
+#ifndef ILI_READ_LOW_NS
+	#define ILI_READ_LOW_NS		355
+#endif
+#ifndef ILI_READ_HIGH_NS
+	#define ILI_READ_HIGH_NS	95		// tRCFM - tRDLFM, more than tRDHFM
+#endif
+// Busy-wait at least `ns` nanoseconds on the cycle counter
+#define ILI_READ_DELAY_NS(ns)	{ \
+								uint32_t _ili_cycles = (rcc_ahb_frequency / 1000000 * (ns) + 999) / 1000; \
+								uint32_t _ili_start = DWT_CYCCNT; \
+								while (DWT_CYCCNT - _ili_start < _ili_cycles); \
+							}
+
+#ifdef SIMULATOR_PLATFORM
+	#define ILI_WRITE_8BIT(d)	{ili_sim_data_out((uint8_t)(d)); ILI_WR_STROBE;}
+	#define ILI_READ_8BIT(d)	{ILI_RD_ACTIVE; d = ili_sim_data_in(); ILI_RD_IDLE;}
+	#define ILI_DATA_INPUT()
+	#define ILI_DATA_OUTPUT()
+#elif FSMC_PLATFORM
+	// Every access is a complete bus cycle. There is no WR-only strobe, see ili_fill_color()
+	#define ILI_WRITE_8BIT(d)	{ILI_FSMC_DATA = (uint8_t)(d);}
+	#define ILI_READ_8BIT(d)	{d = ILI_FSMC_DATA;}
+	// The FSMC turns the data pins around by itself, reads use the FSMC_BTR1 timing
+	#define ILI_DATA_INPUT()
+	#define ILI_DATA_OUTPUT()
+#else
+	#define ILI_WRITE_8BIT(d)	{GPIO_BSRR(ILI_PORT_DATA) = (uint32_t)(0x00FF0000 | ((d) & 0xFF)); ILI_WR_STROBE;}
+	#define ILI_READ_8BIT(d)	{ \
+									ILI_RD_ACTIVE; \
+									ILI_READ_DELAY_NS(ILI_READ_LOW_NS); \
+									d = (uint8_t)(GPIO_IDR(ILI_PORT_DATA) & 0x00FF); \
+									ILI_RD_IDLE; \
+									ILI_READ_DELAY_NS(ILI_READ_HIGH_NS); \
+								}
+	// The controller drives DB10..DB17 while RD is low, so the MCU must release them first
+	#define ILI_DATA_INPUT()	gpio_set_mode(ILI_PORT_DATA, GPIO_MODE_INPUT, GPIO_CNF_INPUT_FLOAT, \
+									ILI_D0 | ILI_D1 | ILI_D2 | ILI_D3 | ILI_D4 | ILI_D5 | ILI_D6 | ILI_D7)
+	#define ILI_DATA_OUTPUT()	gpio_set_mode(ILI_PORT_DATA, GPIO_MODE_OUTPUT_50_MHZ, GPIO_CNF_OUTPUT_PUSHPULL, \
+									ILI_D0 | ILI_D1 | ILI_D2 | ILI_D3 | ILI_D4 | ILI_D5 | ILI_D6 | ILI_D7)
+#endif
 
 #ifdef USER_DEFAULT_PLATFORM
 	#define ILI_CONFIG_GPIO_CLOCK()	    { \
@@ -314,7 +471,179 @@ AFIO_MAPR_SWJ_CFG_JTAG_OFF_SW_OFF: JTAG-DP disabled and SW-DP disabled
 										/* Remap JTAG pins */ \
 										AFIO_MAPR |= JTAG_REMAPPING_MODE; \
 									}
+#elif FSMC_PLATFORM
+	#define ILI_CONFIG_GPIO_CLOCK()	    { \
+										rcc_periph_clock_enable(RCC_GPIOD); \
+										rcc_periph_clock_enable(RCC_GPIOE); \
+										rcc_periph_clock_enable(RCC_AFIO); \
+										rcc_periph_clock_enable(RCC_FSMC); \
+									}
+	#define ILI_CONFIG_GPIO()			{ \
+										/*Configure FSMC data and control pins */ \
+										gpio_set_mode(GPIOD, \
+											GPIO_MODE_OUTPUT_50_MHZ, \
+											GPIO_CNF_OUTPUT_ALTFN_PUSHPULL, \
+											GPIO0 | GPIO1 | GPIO4 | GPIO5 | GPIO7 | GPIO11 | GPIO14 | GPIO15); \
+										gpio_set_mode(GPIOE, \
+											GPIO_MODE_OUTPUT_50_MHZ, \
+											GPIO_CNF_OUTPUT_ALTFN_PUSHPULL, \
+											GPIO7 | GPIO8 | GPIO9 | GPIO10); \
+										/*Configure ILI_PORT_CTRL GPIO pins */ \
+										gpio_set_mode(ILI_PORT_CTRL, \
+											GPIO_MODE_OUTPUT_50_MHZ, \
+											GPIO_CNF_OUTPUT_PUSHPULL, \
+											ILI_RST); \
+										gpio_set(ILI_PORT_CTRL, ILI_RST); \
+										/*SRAM, 8-bit, write enabled, separate write timing */ \
+										FSMC_BCR1 = FSMC_BCR_MBKEN | FSMC_BCR_WREN | FSMC_BCR_EXTMOD; \
+										FSMC_BTR1 = FSMC_BTR_ADDSETx(ILI_FSMC_READ_ADDSET) | FSMC_BTR_DATASTx(ILI_FSMC_READ_DATAST); \
+										/*FSMC_BWTR has the same layout as FSMC_BTR */ \
+										FSMC_BWTR1 = FSMC_BTR_ADDSETx(ILI_FSMC_ADDSET) | FSMC_BTR_DATASTx(ILI_FSMC_DATAST); \
+									}
+#elif SIMULATOR_PLATFORM
+	#define ILI_CONFIG_GPIO_CLOCK()	    {}
+	#define ILI_CONFIG_GPIO()			{ili_sim_init();}
+#endif
+
+/*************************** DMA configuration START ************************/
+/*
+ * Build with -DILI_USE_DMA to stream pixels with DMA (ili_dma_fill_color(), ili_dma_draw_bitmap()).
+ * Every period of ILI_DMA_TIMER issues three DMA1 requests:
+ * 	CC1 event -> ILI_DMA_CH_DATA    : next precomputed BSRR word to GPIO_BSRR(ILI_PORT_DATA)
+ * 	CC2 event -> ILI_DMA_CH_WR_LOW  : ILI_WR to GPIO_BRR(ILI_PORT_WR)
+ * 	Update    -> ILI_DMA_CH_WR_HIGH : ILI_WR to GPIO_BSRR(ILI_PORT_WR), byte is latched
+ * All three channels count the same number of bytes, so the bus stops by itself
+ * after the last byte. The transfer complete interrupt of ILI_DMA_CH_WR_HIGH
+ * (dma1_channel2_isr) stops the timer and queues the next chunk.
+ * The channels are fixed by the STM32F1 DMA request mapping of TIM2.
+ */
+#ifdef ILI_USE_DMA
+	#define ILI_DMA_TIMER			TIM2
+	#define ILI_DMA_TIMER_RCC		RCC_TIM2
+	#define ILI_DMA_CH_DATA			DMA_CHANNEL5	// TIM2_CH1
+	#define ILI_DMA_CH_WR_LOW		DMA_CHANNEL7	// TIM2_CH2
+	#define ILI_DMA_CH_WR_HIGH		DMA_CHANNEL2	// TIM2_UP
+	#define ILI_DMA_WR_HIGH_IRQ		NVIC_DMA1_CHANNEL2_IRQ
+
+	// Timer ticks per bus byte. Must leave room for three DMA transfers, raise it if bytes get lost.
+	#define ILI_DMA_PERIOD			24
+	// Bitmap bytes converted to BSRR words per chunk. Two buffers of this many words are kept in RAM.
+	#define ILI_DMA_BUF_WORDS		128
+
+	#define ILI_DMA_WAIT()			{while (ili_dma_busy());}
+#else
+	#define ILI_DMA_WAIT()
 #endif
+/*************************** DMA configuration END ************************/
+
+/*************************** TE configuration START ************************/
+/*
+ * The controller pulses its TE (tearing effect) output when the refresh reaches the
+ * scanline set with ili_te_set_scanline() (0: start of vertical blanking). Build with
+ * -DILI_USE_TE and connect TE to ILI_PORT_TE / ILI_TE to count the pulses in the EXTI
+ * interrupt. Without it ili_te_wait() polls the scanline over the bus (GET_SCANLINE).
+ * ILI_TE_EXTI, ILI_TE_IRQ and ILI_TE_ISR must match the pin number, ILI_TE_RCC is the
+ * clock of ILI_PORT_TE (enabled by ili_init(), the FSMC platform does not clock GPIOB otherwise).
+ */
+#ifdef ILI_USE_TE
+	#ifndef ILI_PORT_TE
+		#if defined(USER_DEFAULT_PLATFORM) || defined(FSMC_PLATFORM)
+			#define ILI_PORT_TE		GPIOB
+			#define ILI_TE_RCC		RCC_GPIOB
+			#define ILI_TE			GPIO6
+			#define ILI_TE_EXTI		EXTI6
+			#define ILI_TE_IRQ		NVIC_EXTI9_5_IRQ
+			#define ILI_TE_ISR		exti9_5_isr
+		#else
+			#error "ILI_USE_TE: define ILI_PORT_TE, ILI_TE_RCC, ILI_TE, ILI_TE_EXTI, ILI_TE_IRQ and ILI_TE_ISR for the TE pin"
+		#endif
+	#endif
+	#ifndef ILI_TE_RCC
+		#error "ILI_USE_TE: define ILI_TE_RCC, the clock of ILI_PORT_TE (e.g. RCC_GPIOB)"
+	#endif
+#endif
+/*************************** TE configuration END ************************/
+
+/*************************** Statistics configuration START ************************/
+/*
+ * Build with -DILI_USE_STATS to count the bus traffic and CPU cycles (DWT_CYCCNT)
+ * of every public drawing function. Read them with ili_stats_snapshot().
+ * Without it the counting macros below are empty.
+ * Traffic of nested calls (e.g. ili_fill_color() inside ili_fill_rect()) is
+ * accounted to the outermost function.
+ */
+#define ILI_STATS_OTHER					0	// bus traffic outside of the functions below
+#define ILI_STATS_INIT					1
+#define ILI_STATS_ROTATE_DISPLAY		2
+#define ILI_STATS_SET_ADDRESS_WINDOW	3
+#define ILI_STATS_FILL_COLOR			4
+#define ILI_STATS_FILL_RECT				5
+#define ILI_STATS_FILL_RECT_FAST		6
+#define ILI_STATS_FILL_SCREEN			7
+#define ILI_STATS_DRAW_RECTANGLE		8
+#define ILI_STATS_DRAW_LINE				9
+#define ILI_STATS_DRAW_PIXEL			10
+#define ILI_STATS_DRAW_CHAR				11
+#define ILI_STATS_DRAW_STRING			12
+#define ILI_STATS_DRAW_BITMAP			13
+#define ILI_STATS_DMA_FILL_COLOR		14
+#define ILI_STATS_DMA_DRAW_BITMAP		15
+#define ILI_STATS_DRAW_BITMAP_RLE		16
+#define ILI_STATS_DRAW_BITMAP_INDEXED	17
+#define ILI_STATS_SCROLL_DEFINE			18
+#define ILI_STATS_SCROLL				19	// ili_scroll() and ili_scroll_to()
+#define ILI_STATS_READ_RECT				20
+#define ILI_STATS_READ_PIXEL			21
+#define ILI_STATS_COPY_RECT				22
+#define ILI_STATS_TE_SET_SCANLINE		23
+#define ILI_STATS_TE_WAIT				24
+#define ILI_STATS_GET_SCANLINE			25
+#define ILI_STATS_WRITE_PIXELS			26
+#define ILI_STATS_DRAW_CIRCLE			27
+#define ILI_STATS_FILL_CIRCLE			28
+#define ILI_STATS_DRAW_ELLIPSE			29
+#define ILI_STATS_FILL_ELLIPSE			30
+#define ILI_STATS_DRAW_ROUND_RECT		31
+#define ILI_STATS_FILL_ROUND_RECT		32
+#define ILI_STATS_FILL_POLYGON			33
+#define ILI_STATS_FILL_TRIANGLE			34
+#define ILI_STATS_DRAW_THICK_LINE		35
+#define ILI_STATS_DRAW_POLYLINE			36
+#define ILI_STATS_DRAW_LINE_AA			37
+#define ILI_STATS_DRAW_CIRCLE_AA		38
+#define ILI_STATS_DRAW_BITMAP_PART		39
+#define ILI_STATS_DRAW_STREAM			40
+#define ILI_STATS_DIRTY_FLUSH			41
+#define ILI_STATS_COUNT					42
+
+#ifdef ILI_USE_STATS
+	typedef struct {
+		uint32_t calls;
+		uint32_t commands;		// command bytes
+		uint32_t param_bytes;	// command parameter bytes
+		uint32_t pixel_bytes;	// bytes sent after RAMWR
+		uint32_t window_sets;	// ili_set_address_window() calls
+		uint32_t read_bytes;	// bytes read back (RAMRD)
+		uint32_t cycles;		// CPU cycles spent inside the function (0 on the simulator)
+	} ili_stats_t;
+
+	extern ili_stats_t ili_stats_data[ILI_STATS_COUNT];
+	extern uint8_t ili_stats_current;
+
+	#ifdef SIMULATOR_PLATFORM
+		#define ILI_STATS_CYCLES()		0
+	#else
+		#define ILI_STATS_CYCLES()		DWT_CYCCNT
+	#endif
+	#define ILI_STATS_BEGIN(api)		uint8_t _ili_stats_outer = _ili_stats_begin(api)
+	#define ILI_STATS_END()				_ili_stats_end(_ili_stats_outer)
+	#define ILI_STATS_ADD(field, n)		{ili_stats_data[ili_stats_current].field += (n);}
+#else
+	#define ILI_STATS_BEGIN(api)
+	#define ILI_STATS_END()
+	#define ILI_STATS_ADD(field, n)
+#endif
+/*************************** Statistics configuration END ************************/
 
 #define ILI_SWAP(a, b)		{uint16_t temp; temp = a; a = b; b = temp;}
 
@@ -329,8 +658,13 @@ AFIO_MAPR_SWJ_CFG_JTAG_OFF_SW_OFF: JTAG-DP disabled and SW-DP disabled
 __attribute__((always_inline)) static inline void _ili_write_command_8bit(uint8_t cmd)
 {
 	//CS_ACTIVE;
+	ILI_STATS_ADD(commands, 1);
+#ifdef FSMC_PLATFORM
+	ILI_FSMC_CMD = cmd;
+#else
 	ILI_DC_CMD;
 	ILI_WRITE_8BIT(cmd);
+#endif
 }
 
 /*
@@ -340,6 +674,7 @@ __attribute__((always_inline)) static inline void _ili_write_command_8bit(uint8_
 __attribute__((always_inline)) static inline  void _ili_write_data_8bit(uint8_t dat)
 {
 	//CS_ACTIVE;
+	ILI_STATS_ADD(param_bytes, 1);
 	ILI_DC_DAT;
 	ILI_WRITE_8BIT(dat);
 }
@@ -351,6 +686,7 @@ __attribute__((always_inline)) static inline  void _ili_write_data_8bit(uint8_t
 __attribute__((always_inline)) static inline void _ili_write_data_16bit(uint16_t dat)
 {
 	//CS_ACTIVE;
+	ILI_STATS_ADD(param_bytes, 2);
 	ILI_DC_DAT;
 	ILI_WRITE_8BIT((uint8_t)(dat >> 8));
 	ILI_WRITE_8BIT((uint8_t)dat);
@@ -366,6 +702,96 @@ __attribute__((always_inline)) static inline void _ili_write_data_16bit(uint16_t
  */
 void ili_set_address_window(uint16_t x1, uint16_t y1, uint16_t x2, uint16_t y2);
 
+/**
+ * Forget the address window cached by ili_set_address_window(), so that the next
+ * call sends both CASET and PASET again.
+ * Call it after sending CASET, PASET or a reset to the display directly.
+ */
+void ili_invalidate_address_window(void);
+
+/*
+ * Number of clip rectangles ili_clip_push() can save
+ */
+#ifndef ILI_CLIP_STACK_DEPTH
+	#define ILI_CLIP_STACK_DEPTH	8
+#endif
+
+/**
+ * Restrict drawing to the part of the rectangle (x,y,w,h) inside the current clip rectangle.
+ * Every drawing function clips its address windows to it, so widgets can draw content that is
+ * partly hidden without splitting it. The current clip rectangle is saved, ili_clip_pop() brings it back.
+ * @param x Start col address
+ * @param y Start row address
+ * @param w Width of the rectangle
+ * @param h Height of the rectangle
+ * @return 1 if done, 0 if ILI_CLIP_STACK_DEPTH rectangles are pushed already (the clip rectangle is unchanged)
+ */
+uint8_t ili_clip_push(uint16_t x, uint16_t y, uint16_t w, uint16_t h);
+
+/**
+ * Restore the clip rectangle saved by the last ili_clip_push()
+ */
+void ili_clip_pop(void);
+
+/**
+ * Clip to the whole screen and empty the clip stack. Done by ili_init() and ili_rotate_display().
+ */
+void ili_clip_reset(void);
+
+/*
+ * Intersect an area with the clip rectangle. Returns 0 if nothing is left.
+ * User need NOT call it
+ */
+uint8_t _ili_clip_area(int32_t *x1, int32_t *y1, int32_t *x2, int32_t *y2);
+
+/*
+ * Set the address window to the visible part of an image. Returns 0 if nothing is visible.
+ * User need NOT call it
+ */
+uint8_t _ili_clip_window(int32_t x, int32_t y, uint16_t w, uint16_t h, uint16_t *col, uint16_t *row, uint16_t *cols, uint16_t *rows);
+
+/*
+ * Number of rectangles ili_dirty_add() keeps before it merges the closest ones (at least 2)
+ */
+#ifndef ILI_DIRTY_MAX_RECTS
+	#define ILI_DIRTY_MAX_RECTS		16
+#endif
+/*
+ * Bus bytes a separate dirty region costs on top of its pixels: the address windows its redraw
+ * sets (11 bytes each). Two regions are merged when the pixels their bounding box adds cost less.
+ */
+#ifndef ILI_DIRTY_REGION_BYTES
+	#define ILI_DIRTY_REGION_BYTES	44
+#endif
+
+// Redraw callback of ili_dirty_flush(): draws the content of the region (x,y,w,h)
+typedef void (*ili_dirty_redraw_t)(uint16_t x, uint16_t y, uint16_t w, uint16_t h, void *ctx);
+
+/**
+ * Mark the rectangle (x,y,w,h) as changed, to be redrawn by ili_dirty_flush().
+ * Overlapping and nearby rectangles are merged when that costs fewer bus bytes.
+ * @param x Start col address
+ * @param y Start row address
+ * @param w Width of the rectangle
+ * @param h Height of the rectangle
+ */
+void ili_dirty_add(uint16_t x, uint16_t y, uint16_t w, uint16_t h);
+
+/**
+ * Redraw the regions marked by ili_dirty_add() and remove them from the list. For every region
+ * the clip rectangle is set to it and `redraw` is called, so only the region goes over the bus.
+ * @param redraw Function drawing the screen content of the region (x,y,w,h)
+ * @param ctx Passed to `redraw` unchanged
+ * @return 1 if all regions were redrawn, 0 if the clip stack was full (ILI_CLIP_STACK_DEPTH):
+ * the regions not redrawn stay in the list for the next call
+ */
+uint8_t ili_dirty_flush(ili_dirty_redraw_t redraw, void *ctx);
+
+/**
+ * Forget all regions marked by ili_dirty_add(), e.g. after the whole screen was redrawn
+ */
+void ili_dirty_clear(void);
+
 /**
  * Fills `len` number of pixels with `color`.
  * Call ili_set_address_window() before calling this function.
@@ -395,6 +821,239 @@ void ili_draw_line(uint16_t x0, uint16_t y0, uint16_t x1, uint16_t y1, uint8_t w
  */
 void ili_draw_rectangle(uint16_t x, uint16_t y, uint16_t w, uint16_t h, uint16_t color);
 
+/*
+ * Fill the area (x1,y1)-(x2,y2), corners included, clipped to the screen.
+ * Called by the circle, ellipse and rounded rectangle functions.
+ * User need NOT call it
+ */
+void _ili_fill_area(int32_t x1, int32_t y1, int32_t x2, int32_t y2, uint16_t color);
+
+/*
+ * Circle outline with the right half moved by dx and the bottom half by dy.
+ * Called by ili_draw_circle() and ili_draw_round_rect().
+ * User need NOT call it
+ */
+void _ili_draw_circle_helper(int32_t x0, int32_t y0, int32_t r, int32_t dx, int32_t dy, uint16_t color);
+
+/*
+ * Filled circle with the right half moved by dx and the bottom half by dy.
+ * Called by ili_fill_circle() and ili_fill_round_rect().
+ * User need NOT call it
+ */
+void _ili_fill_circle_helper(int32_t x0, int32_t y0, int32_t r, int32_t dx, int32_t dy, uint16_t color);
+
+/**
+ * Draw a circle outline. Pixels on the same row or column are sent as one span.
+ * @param x0 center col address
+ * @param y0 center row address
+ * @param r radius
+ * @param color 16-bit RGB565 color
+ */
+void ili_draw_circle(uint16_t x0, uint16_t y0, uint16_t r, uint16_t color);
+
+/**
+ * Draw a filled circle. Every row is one address window and one fill.
+ * @param x0 center col address
+ * @param y0 center row address
+ * @param r radius
+ * @param color 16-bit RGB565 color
+ */
+void ili_fill_circle(uint16_t x0, uint16_t y0, uint16_t r, uint16_t color);
+
+/**
+ * Draw an ellipse outline
+ * @param x0 center col address
+ * @param y0 center row address
+ * @param rx horizontal radius
+ * @param ry vertical radius
+ * @param color 16-bit RGB565 color
+ */
+void ili_draw_ellipse(uint16_t x0, uint16_t y0, uint16_t rx, uint16_t ry, uint16_t color);
+
+/**
+ * Draw a filled ellipse. Every row is one address window and one fill.
+ * @param x0 center col address
+ * @param y0 center row address
+ * @param rx horizontal radius
+ * @param ry vertical radius
+ * @param color 16-bit RGB565 color
+ */
+void ili_fill_ellipse(uint16_t x0, uint16_t y0, uint16_t rx, uint16_t ry, uint16_t color);
+
+/**
+ * Draw a rectangle with rounded corners
+ * @param x start column address
+ * @param y start row address
+ * @param w width of rectangle
+ * @param h height of rectangle
+ * @param r corner radius, limited to half of the shorter side
+ * @param color 16-bit RGB565 color
+ */
+void ili_draw_round_rect(uint16_t x, uint16_t y, uint16_t w, uint16_t h, uint16_t r, uint16_t color);
+
+/**
+ * Draw a filled rectangle with rounded corners. The straight middle part is a single fill.
+ * @param x start column address
+ * @param y start row address
+ * @param w width of rectangle
+ * @param h height of rectangle
+ * @param r corner radius, limited to half of the shorter side
+ * @param color 16-bit RGB565 color
+ */
+void ili_fill_round_rect(uint16_t x, uint16_t y, uint16_t w, uint16_t h, uint16_t r, uint16_t color);
+
+/*
+ * Polygon vertex. Signed, so vertices may lie off-screen.
+ */
+typedef struct {
+	int16_t x;
+	int16_t y;
+} ili_point_t;
+
+// Fill rules of ili_fill_polygon()
+#define ILI_FILL_EVEN_ODD		0		// inside if a ray crosses an odd number of edges
+#define ILI_FILL_NON_ZERO		1		// inside if the edges wind around the point
+
+/*
+ * Maximum number of vertices of ili_fill_polygon(). The edge table is static RAM,
+ * 30 bytes per vertex.
+ */
+#ifndef ILI_POLYGON_MAX_POINTS
+	#define ILI_POLYGON_MAX_POINTS	32
+#endif
+#if ILI_POLYGON_MAX_POINTS < 18
+	#error "ILI_POLYGON_MAX_POINTS: a thick line with two round caps needs 18 vertices"
+#endif
+
+/*
+ * Fill a polygon with vertices in 1/(1 << shift) pixel units, nothing for more than
+ * ILI_POLYGON_MAX_POINTS vertices.
+ * Called by ili_fill_polygon() and the thick line functions.
+ * User need NOT call it
+ */
+void _ili_fill_polygon(const ili_point_t *points, uint16_t count, uint8_t shift, uint8_t rule, uint16_t color);
+
+/**
+ * Fill a polygon, convex or concave. Vertices are pixel corners: a pixel is filled when its
+ * center lies inside, so polygons sharing an edge never overlap. Every pixel is written once,
+ * one span per inside run of a row.
+ * @param points vertices, the last one is joined to the first one. Coordinates may be off-screen.
+ * @param count number of vertices, up to ILI_POLYGON_MAX_POINTS
+ * @param rule ILI_FILL_EVEN_ODD or ILI_FILL_NON_ZERO
+ * @param color 16-bit RGB565 color
+ * @return 1 if done, 0 if count is above ILI_POLYGON_MAX_POINTS (nothing is drawn)
+ */
+uint8_t ili_fill_polygon(const ili_point_t *points, uint16_t count, uint8_t rule, uint16_t color);
+
+/**
+ * Fill a triangle. Same pixel rule as ili_fill_polygon().
+ * @param x0 column of the 1st vertex
+ * @param y0 row of the 1st vertex
+ * @param x1 column of the 2nd vertex
+ * @param y1 row of the 2nd vertex
+ * @param x2 column of the 3rd vertex
+ * @param y2 row of the 3rd vertex
+ * @param color 16-bit RGB565 color
+ */
+void ili_fill_triangle(uint16_t x0, uint16_t y0, uint16_t x1, uint16_t y1, uint16_t x2, uint16_t y2, uint16_t color);
+
+// Line caps of ili_draw_thick_line() and ili_draw_polyline()
+#define ILI_CAP_BUTT			0		// ends at the end point
+#define ILI_CAP_SQUARE			1		// extends half the width past the end point
+#define ILI_CAP_ROUND			2		// half circle around the end point
+
+// Line joins of ili_draw_polyline()
+#define ILI_JOIN_MITER			0		// sharp corner, beveled when longer than ILI_MITER_LIMIT
+#define ILI_JOIN_BEVEL			1		// corner cut off
+#define ILI_JOIN_ROUND			2		// circle around the corner
+
+/*
+ * Longest miter join, in half line widths
+ */
+#ifndef ILI_MITER_LIMIT
+	#define ILI_MITER_LIMIT		2
+#endif
+
+/*
+ * Thick lines are polygons with vertices in 1/(1 << ILI_LINE_SUBPIXEL_SHIFT) pixels,
+ * so their coordinates must stay below 32768 >> ILI_LINE_SUBPIXEL_SHIFT. The check covers
+ * the screen plus the longest miter of the widest line.
+ */
+#ifndef ILI_LINE_SUBPIXEL_SHIFT
+	#define ILI_LINE_SUBPIXEL_SHIFT	4
+#endif
+#if ((320 + ILI_MITER_LIMIT * 128) << ILI_LINE_SUBPIXEL_SHIFT) > 32767
+	#error "ILI_LINE_SUBPIXEL_SHIFT: sub-pixel line coordinates overflow int16_t"
+#endif
+
+/*
+ * Fill a line segment with sub-pixel end points and half width `r`, caps at both ends.
+ * Called by ili_draw_line(), ili_draw_thick_line() and ili_draw_polyline().
+ * User need NOT call it
+ */
+void _ili_fill_line_segment(int32_t x0, int32_t y0, int32_t x1, int32_t y1, int32_t r, uint8_t cap0, uint8_t cap1, uint16_t color);
+
+/**
+ * Draw a thick line as one filled polygon, centered on the pixels (x0,y0) and (x1,y1).
+ * Every pixel is written once, one span per row.
+ * @param x0 start column address
+ * @param y0 start row address
+ * @param x1 end column address
+ * @param y1 end row address
+ * @param width width of the line in pixels
+ * @param cap ILI_CAP_BUTT, ILI_CAP_SQUARE or ILI_CAP_ROUND
+ * @param color 16-bit RGB565 color
+ */
+void ili_draw_thick_line(uint16_t x0, uint16_t y0, uint16_t x1, uint16_t y1, uint8_t width, uint8_t cap, uint16_t color);
+
+/**
+ * Draw connected thick lines through `points`, centered on the pixels.
+ * The segments are filled as outlines with their joins, so no pixel is written twice.
+ * @param points vertices of the polyline
+ * @param count number of vertices
+ * @param width width of the lines in pixels
+ * @param cap ILI_CAP_BUTT, ILI_CAP_SQUARE or ILI_CAP_ROUND, for both ends of the polyline
+ * @param join ILI_JOIN_MITER (beveled beyond ILI_MITER_LIMIT), ILI_JOIN_BEVEL or ILI_JOIN_ROUND
+ * @param color 16-bit RGB565 color
+ */
+void ili_draw_polyline(const ili_point_t *points, uint16_t count, uint8_t width, uint8_t cap, uint8_t join, uint16_t color);
+
+/*
+ * Number of blending steps between the background and the color of anti-aliased drawing
+ */
+#define ILI_AA_LEVELS			16
+
+/*
+ * Longest run of anti-aliased pixel pairs sent as one address window. Longer runs are split.
+ * The coverage of a run is buffered on the stack, 1 byte per step.
+ */
+#ifndef ILI_AA_RUN_MAX
+	#define ILI_AA_RUN_MAX		64
+#endif
+
+/**
+ * Draw an anti-aliased 1 pixel line (Xiaolin Wu) over a known, plain background.
+ * Pixels are blended between `color` and `bg` by a precomputed ramp, nothing is read back.
+ * The steps of one pixel row (or column for steep lines) are sent as one address window.
+ * @param x0 start column address
+ * @param y0 start row address
+ * @param x1 end column address
+ * @param y1 end row address
+ * @param color 16-bit RGB565 color of the line
+ * @param bg 16-bit RGB565 color of the background under the line
+ */
+void ili_draw_line_aa(uint16_t x0, uint16_t y0, uint16_t x1, uint16_t y1, uint16_t color, uint16_t bg);
+
+/**
+ * Draw an anti-aliased 1 pixel circle (Xiaolin Wu) over a known, plain background.
+ * @param x0 center col address
+ * @param y0 center row address
+ * @param r radius
+ * @param color 16-bit RGB565 color of the circle
+ * @param bg 16-bit RGB565 color of the background under the circle
+ */
+void ili_draw_circle_aa(uint16_t x0, uint16_t y0, uint16_t r, uint16_t color, uint16_t bg);
+
 /*
  * Called by ili_draw_line().
  * User need not call it
@@ -425,6 +1084,46 @@ void _ili_draw_fast_v_line(uint16_t x0, uint16_t y0, uint16_t y1, uint8_t width,
  */
 void ili_rotate_display(uint8_t rotation);
 
+/*
+ * Number of gate lines of the panel. Hardware scrolling moves the image along them:
+ * top to bottom in rotation 0 and 2, left to right in rotation 1 and 3.
+ */
+#define ILI_SCROLL_LINES	320
+
+/**
+ * Define the hardware scrolling area. Lines in the fixed areas don't move.
+ * `top_fixed` and `bottom_fixed` are counted along the scroll axis in the current rotation:
+ * top and bottom in rotation 0 and 2, left and right in rotation 1 and 3.
+ * The scroll position is set back to 0. ili_scroll_define(0, 0) scrolls the whole screen.
+ * @param top_fixed number of lines fixed at the start of the scroll axis
+ * @param bottom_fixed number of lines fixed at the end of the scroll axis
+ */
+void ili_scroll_define(uint16_t top_fixed, uint16_t bottom_fixed);
+
+/**
+ * Set the scroll position: the scroll area shows its content starting at line `offset`.
+ * Only sends VSCRSADD, GRAM is not touched.
+ * @param offset content line (0 to scroll area height - 1) shown first in the scroll area
+ */
+void ili_scroll_to(uint16_t offset);
+
+/**
+ * Move the content of the scroll area by `lines` towards the start of the scroll axis
+ * (up in rotation 0 and 2, left in rotation 1 and 3). Negative values move it back.
+ * The lines exposed at the other end still show old content, redraw them using ili_scroll_line().
+ * @param lines number of lines to scroll
+ */
+void ili_scroll(int16_t lines);
+
+/**
+ * Translate a position on the scroll axis as seen on screen to the coordinate to draw at.
+ * Positions in the fixed areas are returned unchanged.
+ * Consecutive screen lines stay consecutive except where the scroll area wraps around.
+ * @param line y in rotation 0 and 2, x in rotation 1 and 3
+ * @return coordinate to pass to the drawing functions
+ */
+uint16_t ili_scroll_line(uint16_t line);
+
 /**
  * Initialize the display driver
  */
@@ -432,7 +1131,7 @@ void ili_init();
 
 /**
  * Fills a rectangular area with `color`.
- * Before filling, performs area bound checking
+ * The area is clipped to the clip rectangle (the screen unless ili_clip_push() was called)
  * @param x Start col address
  * @param y Start row address
  * @param w Width of rectangle
@@ -442,22 +1141,43 @@ void ili_init();
 void ili_fill_rect(uint16_t x, uint16_t y, uint16_t w, uint16_t h, uint16_t color);
 
 /*
- * Same as `ili_fill_rect()` but does not do bound checking, so it's slightly faster
+ * Same as `ili_fill_rect()`, kept for existing code
  */
 void ili_fill_rect_fast(uint16_t x, uint16_t y, uint16_t w, uint16_t h, uint16_t color);
 
 /**
- * Fill the entire display (screen) with `color`
+ * Fill the entire display (screen) with `color`, or the clip rectangle if one was pushed
  * @param color 16-bit RGB565 color
  */
 void ili_fill_screen(uint16_t color);
 
+/*
+ * Find the glyph of `code` in `font` using the font's lookup method (see bitmap_typedefs.h)
+ * Returns NULL if the font has no such glyph. Called by `ili_draw_char()` and `_ili_draw_string_main()`
+ * User need NOT call it
+ */
+const tImage *_ili_get_glyph(const tFont *font, long int code);
+
 /*
  * Render a character glyph on the display. Called by `ili_draw_string_main()`
  * User need NOT call it
  */
 void _ili_render_glyph(uint16_t x, uint16_t y, uint16_t fore_color, uint16_t back_color, const tImage *glyph, uint8_t is_bg);
 
+/*
+ * Render a glyph with background color through one address window covering the glyph cell.
+ * Called by `_ili_render_glyph()`
+ * User need NOT call it
+ */
+void _ili_render_glyph_bg(uint16_t x, uint16_t y, uint16_t fore_color, uint16_t back_color, const tImage *glyph);
+
+/*
+ * Render a glyph with transparent background as vertical runs of ink pixels.
+ * Called by `_ili_render_glyph()`
+ * User need NOT call it
+ */
+void _ili_render_glyph_spans(uint16_t x, uint16_t y, uint16_t color, const tImage *glyph);
+
 /**
  * Renders a string by drawing each character glyph from the passed string.
  * Called by `ili_draw_string()` and `ili_draw_string_withbg()`.
@@ -510,8 +1230,211 @@ void ili_draw_char(uint16_t x, uint16_t y, char character, uint16_t fore_color,
  * @param bitmap Pointer to the image data to be drawn
  */
 void ili_draw_bitmap(uint16_t x, uint16_t y, const tImage *bitmap);
+
+/**
+ * Draw the `w` x `h` part of `bitmap` starting at (src_x,src_y) of the image, e.g. one sprite
+ * of a sprite sheet. The part is cut to the image, then clipped like `ili_draw_bitmap()`.
+ * @param x Start col address on the display
+ * @param y Start row address on the display
+ * @param bitmap Pointer to the image
+ * @param src_x Start col in the image
+ * @param src_y Start row in the image
+ * @param w Width of the part
+ * @param h Height of the part
+ */
+void ili_draw_bitmap_part(uint16_t x, uint16_t y, const tImage *bitmap, uint16_t src_x, uint16_t src_y, uint16_t w, uint16_t h);
 //void ili_draw_bitmap_old(uint16_t x, uint16_t y, const tImage16bit *bitmap);
 
+/**
+ * Write a rendered area to the display, e.g. the flush callback of a UI library.
+ * @param x1 start column address
+ * @param y1 start row address
+ * @param x2 end column address
+ * @param y2 end row address
+ * @param buf (x2 - x1 + 1) * (y2 - y1 + 1) RGB565 pixels, row by row, native byte order
+ */
+void ili_write_pixels(uint16_t x1, uint16_t y1, uint16_t x2, uint16_t y2, const uint16_t *buf);
+
+/**
+ * Draw a run-length encoded image on the display (format described in bitmap_typedefs.h).
+ * The image is decoded straight to the display, no RAM buffer is used.
+ * @param x Start col address
+ * @param y Start row address
+ * @param bitmap Pointer to the encoded image
+ */
+void ili_draw_bitmap_rle(uint16_t x, uint16_t y, const tImageRLE *bitmap);
+
+/**
+ * Draw a palette indexed image (1, 2, 4 or 8 bpp) on the display.
+ * Indices are expanded to RGB565 while streaming, no frame buffer is used.
+ * @param x Start col address
+ * @param y Start row address
+ * @param bitmap Pointer to the image data and its palette
+ */
+void ili_draw_bitmap_indexed(uint16_t x, uint16_t y, const tImageIndexed *bitmap);
+
+/**
+ * Fills `len` number of pixels with `color` using DMA and returns immediately.
+ * Call ili_set_address_window() before calling this function.
+ * Without ILI_USE_DMA it falls back to `ili_fill_color()` and completes before returning.
+ * @param color 16-bit RGB565 color value
+ * @param len 32-bit number of pixels
+ */
+void ili_dma_fill_color(uint16_t color, uint32_t len);
+
+/**
+ * Draw a bitmap image on the display using DMA and return immediately.
+ * The bitmap must stay valid until the transfer is complete.
+ * Without ILI_USE_DMA it falls back to `ili_draw_bitmap()` and completes before returning.
+ * @param x Start col address
+ * @param y Start row address
+ * @param bitmap Pointer to the image data to be drawn
+ */
+void ili_dma_draw_bitmap(uint16_t x, uint16_t y, const tImage *bitmap);
+
+/**
+ * Check if a DMA transfer is still running.
+ * Other drawing functions wait for it by themselves.
+ * @return 1 if busy, 0 if done
+ */
+uint8_t ili_dma_busy(void);
+
+/**
+ * Set a function to be called when a DMA transfer is complete.
+ * With ILI_USE_DMA it is called from the DMA interrupt.
+ * @param callback function pointer, NULL to disable
+ */
+void ili_dma_set_callback(void (*callback)(void));
+
+/*
+ * Chunk size (bytes) of ili_draw_stream(). With ILI_USE_DMA two buffers are kept, one is
+ * filled while the other is sent.
+ */
+#ifndef ILI_STREAM_BUF_BYTES
+	#define ILI_STREAM_BUF_BYTES	512
+#endif
+#ifdef ILI_USE_DMA
+	#define ILI_STREAM_BUFS			2
+#else
+	#define ILI_STREAM_BUFS			1
+#endif
+
+// Pixel source of ili_draw_stream(): copies up to `len` image bytes to `buf`, returns the number copied
+typedef uint32_t (*ili_stream_read_t)(void *ctx, uint8_t *buf, uint32_t len);
+
+/**
+ * Draw a `w` x `h` RGB565 image whose pixels are pulled through `read`, e.g. from external
+ * flash or a serial link. The image is fetched in chunks of up to ILI_STREAM_BUF_BYTES.
+ * With ILI_USE_DMA the next chunk is fetched while the previous one is sent.
+ * Clipped like `ili_draw_bitmap()`. Returns when the image is drawn.
+ * @param x Start col address
+ * @param y Start row address
+ * @param w Width of the image
+ * @param h Height of the image
+ * @param read Function copying up to `len` bytes of the image to `buf` (row major, 2 bytes per
+ * pixel, high byte first like tImage data). It returns the number of bytes copied, 0 stops drawing.
+ * @param ctx Passed to `read` unchanged
+ */
+void ili_draw_stream(uint16_t x, uint16_t y, uint16_t w, uint16_t h, ili_stream_read_t read, void *ctx);
+
+/**
+ * Set the scanline at which the TE output pulses and ili_te_wait() returns.
+ * 0 is the start of vertical blanking. After ili_init() it is 0.
+ * @param line panel scanline (0 to 319)
+ */
+void ili_te_set_scanline(uint16_t line);
+
+/**
+ * Wait until the panel refresh reaches the TE scanline (see ili_te_set_scanline()).
+ * Start a frame update right after it returns so the writes stay behind the refresh.
+ */
+void ili_te_wait(void);
+
+/**
+ * Read the scanline the panel is refreshing now (GET_SCANLINE)
+ * @return current scanline
+ */
+uint16_t ili_get_scanline(void);
+
+#ifdef ILI_USE_STATS
+/*
+ * Called by ILI_STATS_BEGIN() / ILI_STATS_END().
+ * User need not call it
+ */
+uint8_t _ili_stats_begin(uint8_t api);
+
+/*
+ * Called by ILI_STATS_END().
+ * User need not call it
+ */
+void _ili_stats_end(uint8_t outer);
+
+/**
+ * Copy the statistics of all functions, indexed by ILI_STATS_*
+ * @param snapshot array of ILI_STATS_COUNT entries
+ */
+void ili_stats_snapshot(ili_stats_t *snapshot);
+
+/**
+ * Clear the statistics of all functions
+ */
+void ili_stats_reset(void);
+
+/**
+ * Name of the function counted at index `api`
+ * @param api one of ILI_STATS_*
+ * @return function name
+ */
+const char *ili_stats_name(uint8_t api);
+#endif
+
+/**
+ * Read a rectangular area of GRAM into `buf` (RAMRD).
+ * Pixels are stored row by row as RGB565, the same format the drawing functions take.
+ * The area must be on screen, otherwise nothing is read.
+ * @param x Start col address
+ * @param y Start row address
+ * @param w Width of the area
+ * @param h Height of the area
+ * @param buf Destination of w * h pixels
+ */
+void ili_read_rect(uint16_t x, uint16_t y, uint16_t w, uint16_t h, uint16_t *buf);
+
+/**
+ * Read the color of one pixel
+ * @param x col address
+ * @param y row address
+ * @return 16-bit RGB565 color, 0 if the pixel is off screen
+ */
+uint16_t ili_read_pixel(uint16_t x, uint16_t y);
+
+/*
+ * Size (pixels) of the RAM buffer used by ili_copy_rect(). A larger buffer moves more
+ * rows per RAMRD / RAMWR pair. Rows wider than the buffer are copied in pieces.
+ */
+#ifndef ILI_COPY_BUF_PIXELS
+	#define ILI_COPY_BUF_PIXELS	320
+#endif
+
+/**
+ * Copy a rectangular area of the screen to another position (GRAM read back and rewritten).
+ * Overlapping areas are copied in the right order. Both areas must be on screen.
+ * @param src_x Source start col address
+ * @param src_y Source start row address
+ * @param dst_x Destination start col address
+ * @param dst_y Destination start row address
+ * @param w Width of the area
+ * @param h Height of the area
+ */
+void ili_copy_rect(uint16_t src_x, uint16_t src_y, uint16_t dst_x, uint16_t dst_y, uint16_t w, uint16_t h);
+
+/*
+ * Write `len` RGB565 pixels from `pixels` into the current address window.
+ * Call ili_set_address_window() before calling this function.
+ * User need NOT call it
+ */
+void _ili_write_pixels(const uint16_t *pixels, uint32_t len);
+
 /**
  * Draw a pixel at a given position with `color`
  * @param x Start col address
@@ -0,0 +1,497 @@
+/*
+MIT License
+
+Copyright (c) 2020 Avra Mitra
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+#include <stdio.h>
+#include <string.h>
+#include "ili9341_sim.h"
+#include <ili9341_stm32_parallel8.h>
+
+#define ILI_SIM_RAMWRC		0x3C	// Write memory continue
+#define ILI_SIM_RAMRDC		0x3E	// Read memory continue
+#define ILI_SIM_MAX_PARAMS	16
+
+uint16_t ili_sim_gram[ILI_SIM_GRAM_HEIGHT][ILI_SIM_GRAM_WIDTH];
+
+// Controller registers and bus state
+static struct {
+	uint8_t pins;
+	uint8_t bus;
+	uint8_t cmd;
+	uint8_t params[ILI_SIM_MAX_PARAMS];
+	uint8_t param_cnt;
+	uint8_t read_cnt;
+	uint16_t col_start, col_end;
+	uint16_t page_start, page_end;
+	uint16_t col, page;			// GRAM read/write pointer
+	uint8_t madctl;
+	uint8_t pixfmt;
+	uint16_t tfa, vsa, bfa;		// VSCRDEF
+	uint16_t vsp;				// VSCRSADD
+	uint16_t scanline;			// latched by GET_SCANLINE
+	uint64_t time_ns;			// bus time since ili_sim_init(), drives the refresh position
+	uint8_t pixel_high;
+	uint8_t pixel_phase;
+} sim;
+
+static ili_sim_stats_t stats;
+
+
+
+/*
+ * Registers to their reset defaults (datasheet 8.2). GRAM is not touched.
+ */
+static void _ili_sim_reset_registers(void)
+{
+	sim.cmd = ILI_NOP;
+	sim.param_cnt = 0;
+	sim.read_cnt = 0;
+	sim.col_start = 0;
+	sim.col_end = ILI_SIM_GRAM_WIDTH - 1;
+	sim.page_start = 0;
+	sim.page_end = ILI_SIM_GRAM_HEIGHT - 1;
+	sim.col = 0;
+	sim.page = 0;
+	sim.madctl = 0;
+	sim.pixfmt = 0x66;
+	sim.tfa = 0;
+	sim.vsa = ILI_SIM_GRAM_HEIGHT;
+	sim.bfa = 0;
+	sim.vsp = 0;
+	sim.pixel_phase = 0;
+}
+
+
+/*
+ * Address range of the column and page counters for the current MADCTL.
+ */
+static uint16_t _ili_sim_col_max(void)
+{
+	return (sim.madctl & 0x20) ? ILI_SIM_GRAM_HEIGHT - 1 : ILI_SIM_GRAM_WIDTH - 1;
+}
+
+static uint16_t _ili_sim_page_max(void)
+{
+	return (sim.madctl & 0x20) ? ILI_SIM_GRAM_WIDTH - 1 : ILI_SIM_GRAM_HEIGHT - 1;
+}
+
+
+/*
+ * Map the current column/page pointer to a GRAM cell. MX and MY mirror the
+ * counters, MV exchanges them. Returns NULL if the pointer is out of range.
+ * GRAM is kept as seen on the glass: common modules have the source driver
+ * reversed, so MX = 1 is the upright image.
+ */
+static uint16_t *_ili_sim_cell(void)
+{
+	uint16_t col_max = _ili_sim_col_max();
+	uint16_t page_max = _ili_sim_page_max();
+	uint16_t c = sim.col;
+	uint16_t p = sim.page;
+
+	if (c > col_max || p > page_max)
+		return NULL;
+
+	if (sim.madctl & 0x40)		//MX
+		c = col_max - c;
+	if (sim.madctl & 0x80)		//MY
+		p = page_max - p;
+
+	if (sim.madctl & 0x20)		//MV
+		return &ili_sim_gram[c][ILI_SIM_GRAM_WIDTH - 1 - p];
+	return &ili_sim_gram[p][ILI_SIM_GRAM_WIDTH - 1 - c];
+}
+
+
+/*
+ * Advance the pointer inside the window set by CASET/PASET, wrapping to the
+ * start of the window after the last cell like the real controller does.
+ */
+static void _ili_sim_advance(void)
+{
+	if (sim.col >= sim.col_end)
+	{
+		sim.col = sim.col_start;
+		if (sim.page >= sim.page_end)
+			sim.page = sim.page_start;
+		else
+			sim.page++;
+	}
+	else
+	{
+		sim.col++;
+	}
+}
+
+
+static void _ili_sim_command(uint8_t cmd)
+{
+	stats.cmd_bytes++;
+	sim.cmd = cmd;
+	sim.param_cnt = 0;
+	sim.read_cnt = 0;
+	sim.pixel_phase = 0;
+
+	switch (cmd)
+	{
+		case ILI_SWRESET:
+			_ili_sim_reset_registers();
+			break;
+		case ILI_RAMWR:
+		case ILI_RAMRD:
+			sim.col = sim.col_start;
+			sim.page = sim.page_start;
+			break;
+		case ILI_GETSCANLINE:
+			sim.scanline = (uint16_t)((sim.time_ns / ILI_SIM_LINE_NS) % ILI_SIM_FRAME_LINES);
+			break;
+		default:
+			break;
+	}
+}
+
+
+static void _ili_sim_pixel_byte(uint8_t dat)
+{
+	uint16_t *cell;
+
+	stats.pixel_bytes++;
+
+	// Only the 16 bpp interface format is modelled
+	if (sim.pixel_phase == 0)
+	{
+		sim.pixel_high = dat;
+		sim.pixel_phase = 1;
+		return;
+	}
+	sim.pixel_phase = 0;
+
+	cell = _ili_sim_cell();
+	if (cell)
+	{
+		*cell = ((uint16_t)sim.pixel_high << 8) | dat;
+		stats.pixels++;
+	}
+	else
+	{
+		stats.dropped_pixels++;
+	}
+	_ili_sim_advance();
+}
+
+
+static void _ili_sim_param_byte(uint8_t dat)
+{
+	stats.param_bytes++;
+
+	if (sim.param_cnt < ILI_SIM_MAX_PARAMS)
+		sim.params[sim.param_cnt] = dat;
+	sim.param_cnt++;
+
+	switch (sim.cmd)
+	{
+		case ILI_CASET:
+			if (sim.param_cnt == 4)
+			{
+				sim.col_start = ((uint16_t)sim.params[0] << 8) | sim.params[1];
+				sim.col_end = ((uint16_t)sim.params[2] << 8) | sim.params[3];
+			}
+			break;
+		case ILI_PASET:
+			if (sim.param_cnt == 4)
+			{
+				sim.page_start = ((uint16_t)sim.params[0] << 8) | sim.params[1];
+				sim.page_end = ((uint16_t)sim.params[2] << 8) | sim.params[3];
+			}
+			break;
+		case ILI_MADCTL:
+			if (sim.param_cnt == 1)
+				sim.madctl = dat;
+			break;
+		case ILI_PIXFMT:
+			if (sim.param_cnt == 1)
+				sim.pixfmt = dat;
+			break;
+		case ILI_VSCRDEF:
+			// Ignored unless the three areas add up to the panel height (datasheet 8.2.30)
+			if (sim.param_cnt == 6)
+			{
+				uint16_t tfa = ((uint16_t)sim.params[0] << 8) | sim.params[1];
+				uint16_t vsa = ((uint16_t)sim.params[2] << 8) | sim.params[3];
+				uint16_t bfa = ((uint16_t)sim.params[4] << 8) | sim.params[5];
+				if (tfa + vsa + bfa == ILI_SIM_GRAM_HEIGHT)
+				{
+					sim.tfa = tfa;
+					sim.vsa = vsa;
+					sim.bfa = bfa;
+				}
+			}
+			break;
+		case ILI_VSCRSADD:
+			if (sim.param_cnt == 2)
+				sim.vsp = ((uint16_t)sim.params[0] << 8) | sim.params[1];
+			break;
+		default:
+			break;
+	}
+}
+
+
+/*
+ * A byte has been latched on the rising edge of WR
+ */
+static void _ili_sim_write_cycle(void)
+{
+	stats.wr_strobes++;
+	stats.bus_ns += ILI_SIM_TWC_NS;
+	sim.time_ns += ILI_SIM_TWC_NS;
+
+	if (!(sim.pins & ILI_SIM_PIN_DC))
+	{
+		_ili_sim_command(sim.bus);
+		return;
+	}
+
+	stats.data_bytes++;
+	if (sim.cmd == ILI_RAMWR || sim.cmd == ILI_SIM_RAMWRC)
+		_ili_sim_pixel_byte(sim.bus);
+	else
+		_ili_sim_param_byte(sim.bus);
+}
+
+
+/*
+ * RD went low, drive the bus. Memory reads start with a dummy byte, then
+ * return every pixel as R, G, B bytes with 6 significant bits each.
+ */
+static void _ili_sim_read_cycle(void)
+{
+	static const uint8_t rddid[4] = {0x00, 0x00, 0x93, 0x41};
+	uint16_t *cell;
+	uint16_t pixel;
+	uint8_t component;
+
+	stats.rd_strobes++;
+	stats.bus_ns += ILI_SIM_TRC_NS;
+	sim.time_ns += ILI_SIM_TRC_NS;
+
+	if (!(sim.pins & ILI_SIM_PIN_DC))
+		return;
+
+	if (sim.cmd == ILI_RDDID)
+	{
+		sim.bus = (sim.read_cnt < 4) ? rddid[sim.read_cnt] : 0;
+		sim.read_cnt++;
+		return;
+	}
+
+	if (sim.cmd == ILI_GETSCANLINE)
+	{
+		// dummy, GTS[9:8], GTS[7:0]
+		if (sim.read_cnt == 1)
+			sim.bus = (uint8_t)(sim.scanline >> 8);
+		else if (sim.read_cnt == 2)
+			sim.bus = (uint8_t)sim.scanline;
+		else
+			sim.bus = 0;
+		sim.read_cnt++;
+		return;
+	}
+
+	if (sim.cmd != ILI_RAMRD && sim.cmd != ILI_SIM_RAMRDC)
+	{
+		sim.bus = 0;
+		return;
+	}
+
+	if (sim.read_cnt == 0)
+	{
+		sim.bus = 0;		//dummy read
+		sim.read_cnt = 1;
+		return;
+	}
+
+	cell = _ili_sim_cell();
+	pixel = cell ? *cell : 0;
+
+	switch (sim.pixel_phase)
+	{
+		case 0:
+			component = (pixel >> 11) & 0x1F;
+			sim.bus = (uint8_t)((component << 3) | (component >> 2));
+			sim.pixel_phase = 1;
+			break;
+		case 1:
+			component = (pixel >> 5) & 0x3F;
+			sim.bus = (uint8_t)(component << 2);
+			sim.pixel_phase = 2;
+			break;
+		default:
+			component = pixel & 0x1F;
+			sim.bus = (uint8_t)((component << 3) | (component >> 2));
+			sim.pixel_phase = 0;
+			_ili_sim_advance();
+			break;
+	}
+	// Only the upper 6 bits carry information
+	sim.bus &= 0xFC;
+}
+
+
+
+/**
+ * Power-on reset of the model: registers, GRAM, pins and counters
+ */
+void ili_sim_init(void)
+{
+	memset(ili_sim_gram, 0, sizeof(ili_sim_gram));
+	sim.pins = ILI_SIM_PIN_RST | ILI_SIM_PIN_CS | ILI_SIM_PIN_DC | ILI_SIM_PIN_WR | ILI_SIM_PIN_RD;
+	sim.bus = 0xFF;
+	sim.time_ns = 0;
+	_ili_sim_reset_registers();
+	ili_sim_reset_stats();
+}
+
+
+/**
+ * Drive control line(s) high
+ * @param pins ILI_SIM_PIN_* mask
+ */
+void ili_sim_pin_set(uint8_t pins)
+{
+	uint8_t rising = pins & ~sim.pins;
+
+	sim.pins |= pins;
+
+	if (rising & ILI_SIM_PIN_RST)
+		_ili_sim_reset_registers();
+
+	if ((rising & ILI_SIM_PIN_WR) && !(sim.pins & ILI_SIM_PIN_CS))
+		_ili_sim_write_cycle();
+}
+
+
+/**
+ * Drive control line(s) low
+ * @param pins ILI_SIM_PIN_* mask
+ */
+void ili_sim_pin_clear(uint8_t pins)
+{
+	uint8_t falling = pins & sim.pins;
+
+	sim.pins &= ~pins;
+
+	if ((falling & ILI_SIM_PIN_RD) && !(sim.pins & ILI_SIM_PIN_CS))
+		_ili_sim_read_cycle();
+}
+
+
+/**
+ * Put a byte on the data bus. It is latched on the next rising edge of WR.
+ * @param dat byte to be written
+ */
+void ili_sim_data_out(uint8_t dat)
+{
+	sim.bus = dat;
+}
+
+
+/**
+ * Sample the data bus. Valid after RD went low during a read command.
+ * @return byte driven by the controller
+ */
+uint8_t ili_sim_data_in(void)
+{
+	return sim.bus;
+}
+
+
+/**
+ * Copy the current bus traffic counters to `snapshot`
+ * @param snapshot destination of the counters
+ */
+void ili_sim_get_stats(ili_sim_stats_t *snapshot)
+{
+	*snapshot = stats;
+}
+
+
+/**
+ * Clear the bus traffic counters
+ */
+void ili_sim_reset_stats(void)
+{
+	memset(&stats, 0, sizeof(stats));
+}
+
+
+/**
+ * Current value of MADCTL
+ * @return MADCTL register value
+ */
+uint8_t ili_sim_get_madctl(void)
+{
+	return sim.madctl;
+}
+
+
+/**
+ * GRAM row shown on panel line `line` with the current scrolling area and start address
+ * @param line panel line (0 to ILI_SIM_GRAM_HEIGHT - 1)
+ * @return GRAM row index
+ */
+uint16_t ili_sim_display_row(uint16_t line)
+{
+	if (line < sim.tfa || line >= sim.tfa + sim.vsa || sim.vsa == 0)
+		return line;
+	uint16_t shift = (sim.vsp + sim.vsa - sim.tfa) % sim.vsa;
+	return sim.tfa + (line - sim.tfa + shift) % sim.vsa;
+}
+
+
+/**
+ * Write the image on the panel (GRAM with scrolling applied) to a binary PPM (P6) file
+ * @param path file name
+ * @return 0 on success, -1 on error
+ */
+int ili_sim_dump_ppm(const char *path)
+{
+	FILE *fp = fopen(path, "wb");
+	if (fp == NULL)
+		return -1;
+
+	fprintf(fp, "P6\n%d %d\n255\n", ILI_SIM_GRAM_WIDTH, ILI_SIM_GRAM_HEIGHT);
+	for (uint16_t row = 0; row < ILI_SIM_GRAM_HEIGHT; row++)
+	{
+		for (uint16_t col = 0; col < ILI_SIM_GRAM_WIDTH; col++)
+		{
+			uint16_t pixel = ili_sim_gram[ili_sim_display_row(row)][col];
+			uint8_t rgb[3];
+			rgb[0] = (uint8_t)(((pixel >> 11) & 0x1F) << 3);
+			rgb[1] = (uint8_t)(((pixel >> 5) & 0x3F) << 2);
+			rgb[2] = (uint8_t)((pixel & 0x1F) << 3);
+			fwrite(rgb, 1, 3, fp);
+		}
+	}
+	fclose(fp);
+	return 0;
+}
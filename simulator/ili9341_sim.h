@@ -0,0 +1,137 @@
+/*
+MIT License
+
+Copyright (c) 2020 Avra Mitra
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+/*
+ * Host-side model of an ILI9341 sitting on an 8080-I 8-bit bus.
+ * Selected by building the driver with -DSIMULATOR_PLATFORM. The bus macros of
+ * ili9341_stm32_parallel8.h then drive the control lines and the data latch of
+ * this model instead of GPIO_BSRR, so the driver source is compiled unchanged.
+ */
+
+#ifndef INC_ILI9341_SIM_H_
+#define INC_ILI9341_SIM_H_
+
+#include <stdint.h>
+
+// Physical GRAM size (MADCTL MV = 0 orientation)
+#define ILI_SIM_GRAM_WIDTH		240
+#define ILI_SIM_GRAM_HEIGHT		320
+
+// Control lines of the simulated bus (bit masks)
+#define ILI_SIM_PIN_RST			0x01
+#define ILI_SIM_PIN_CS			0x02
+#define ILI_SIM_PIN_DC			0x04
+#define ILI_SIM_PIN_WR			0x08
+#define ILI_SIM_PIN_RD			0x10
+
+// Minimum bus cycle times from the ILI9341 datasheet, used to estimate bus time
+#define ILI_SIM_TWC_NS			66		// write cycle
+#define ILI_SIM_TRC_NS			450		// frame memory read cycle
+
+// Panel refresh: 320 lines at 100Hz (FRMCTR1 set by ili_init()). Time advances with the bus cycles.
+#define ILI_SIM_FRAME_LINES		320
+#define ILI_SIM_LINE_NS			31250
+
+/*
+ * Bus traffic counters. Reset them before a call and read them afterwards to get
+ * the cost of that call.
+ */
+typedef struct {
+	uint32_t wr_strobes;		// rising edges of WR while CS is active
+	uint32_t rd_strobes;		// falling edges of RD while CS is active
+	uint32_t cmd_bytes;			// bytes latched with D/C low
+	uint32_t data_bytes;		// bytes latched with D/C high (param_bytes + pixel_bytes)
+	uint32_t param_bytes;		// command parameter bytes
+	uint32_t pixel_bytes;		// bytes written after RAMWR
+	uint32_t pixels;			// pixels stored in GRAM
+	uint32_t dropped_pixels;	// pixels addressed outside GRAM
+	uint64_t bus_ns;			// estimated bus time at minimum cycle times
+} ili_sim_stats_t;
+
+/*
+ * Simulated GRAM in physical order, [row][column], RGB565.
+ */
+extern uint16_t ili_sim_gram[ILI_SIM_GRAM_HEIGHT][ILI_SIM_GRAM_WIDTH];
+
+/**
+ * Power-on reset of the model: registers, GRAM, pins and counters
+ */
+void ili_sim_init(void);
+
+/**
+ * Drive control line(s) high
+ * @param pins ILI_SIM_PIN_* mask
+ */
+void ili_sim_pin_set(uint8_t pins);
+
+/**
+ * Drive control line(s) low
+ * @param pins ILI_SIM_PIN_* mask
+ */
+void ili_sim_pin_clear(uint8_t pins);
+
+/**
+ * Put a byte on the data bus. It is latched on the next rising edge of WR.
+ * @param dat byte to be written
+ */
+void ili_sim_data_out(uint8_t dat);
+
+/**
+ * Sample the data bus. Valid after RD went low during a read command.
+ * @return byte driven by the controller
+ */
+uint8_t ili_sim_data_in(void);
+
+/**
+ * Copy the current bus traffic counters to `snapshot`
+ * @param snapshot destination of the counters
+ */
+void ili_sim_get_stats(ili_sim_stats_t *snapshot);
+
+/**
+ * Clear the bus traffic counters
+ */
+void ili_sim_reset_stats(void);
+
+/**
+ * Current value of MADCTL
+ * @return MADCTL register value
+ */
+uint8_t ili_sim_get_madctl(void);
+
+/**
+ * GRAM row shown on panel line `line` with the current scrolling area and start address
+ * @param line panel line (0 to ILI_SIM_GRAM_HEIGHT - 1)
+ * @return GRAM row index
+ */
+uint16_t ili_sim_display_row(uint16_t line);
+
+/**
+ * Write the image on the panel (GRAM with scrolling applied) to a binary PPM (P6) file
+ * @param path file name
+ * @return 0 on success, -1 on error
+ */
+int ili_sim_dump_ppm(const char *path);
+
+#endif /* INC_ILI9341_SIM_H_ */
@@ -0,0 +1,350 @@
+/*
+MIT License
+
+Copyright (c) 2020 Avra Mitra
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+/*
+ * Runs every drawing path of the driver against the simulated ILI9341 and prints
+ * the bus traffic of each call, followed by a checksum of the resulting GRAM.
+ * Pixels of each primitive are read back and checked, the exit status is 1 if any differs.
+ * Pass a file name to also dump the GRAM as a PPM image.
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include "font_ubuntu_mono_24.h"
+#include "ili9341_stm32_parallel8.h"
+
+// 16x16 RGB565 test pattern, big-endian bytes like lcd-image-converter output
+static uint8_t pattern_data[16 * 16 * 2];
+static const tImage pattern = { pattern_data, 16, 16, 16 };
+
+// 32x32 RLE image: 512 px blue run, 4 px literal, 508 px red run
+static const uint8_t flag_rle_data[] = {
+	0xC1, 0xFF, 0x00, 0x1F,
+	0x03, 0xF8, 0x00, 0x07, 0xE0, 0x00, 0x1F, 0xFF, 0xFF,
+	0xC1, 0xFB, 0xF8, 0x00,
+};
+static const tImageRLE flag_rle = { flag_rle_data, sizeof(flag_rle_data), 32, 32 };
+
+// 16x16 2 bpp image: four horizontal bands, one palette entry each
+static uint8_t bands_data[16 * 16 / 4];
+static const uint16_t bands_palette[] = { ILI_COLOR_NAVY, ILI_COLOR_OLIVE, ILI_COLOR_MAROON, ILI_COLOR_LIGHTGREY };
+static const tImageIndexed bands = { bands_data, bands_palette, 4, 16, 16, 2 };
+
+// Self-intersecting 5-point star: the center is inside for non-zero, outside for even-odd
+static const ili_point_t star[] = { {60, 10}, {82, 78}, {24, 36}, {96, 36}, {38, 78} };
+static const ili_point_t star2[] = { {60, 90}, {82, 158}, {24, 116}, {96, 116}, {38, 158} };
+
+// Chart trace with sharp and shallow turns
+static const ili_point_t trace[] = { {150, 120}, {170, 95}, {190, 110}, {210, 60}, {230, 75}, {250, 70}, {270, 100} };
+
+// Stream source for ili_draw_stream(): hands out the pattern in 100 byte pieces, like a serial link
+static uint32_t _bench_stream_read(void *ctx, uint8_t *buf, uint32_t len)
+{
+	uint32_t *offset = ctx;
+	uint32_t n = sizeof(pattern_data) - *offset;
+	if (n > len)
+		n = len;
+	if (n > 100)
+		n = 100;
+	memcpy(buf, pattern_data + *offset, n);
+	*offset += n;
+	return n;
+}
+
+// Redraw callback of the dirty rectangle bench: repaints the whole panel, clipping keeps it to the region
+static void _bench_redraw_panel(uint16_t x, uint16_t y, uint16_t w, uint16_t h, void *ctx)
+{
+	(void)x; (void)y; (void)w; (void)h;
+	ili_fill_rect(200, 180, 110, 50, ILI_COLOR_DARKGREEN);
+	ili_draw_string(204, 184, (char *)ctx, ILI_COLOR_WHITE, &font_ubuntu_mono_24);
+}
+
+#define BENCH(name, call)	{ili_sim_reset_stats(); call; _bench_report(name);}
+
+static void _bench_report(const char *name)
+{
+	ili_sim_stats_t st;
+	ili_sim_get_stats(&st);
+	printf("%-24s %8u %8u %8u %9u %8u %10.1f\n", name,
+		(unsigned)st.cmd_bytes, (unsigned)st.param_bytes, (unsigned)st.pixel_bytes,
+		(unsigned)st.wr_strobes, (unsigned)st.pixels, (double)st.bus_ns / 1000.0);
+	if (st.dropped_pixels)
+		printf("%-24s %u pixels outside GRAM\n", "", (unsigned)st.dropped_pixels);
+}
+
+/*
+ * Read one pixel back and compare it, returns 1 (and prints it) if it differs
+ */
+static int _bench_expect(const char *what, uint16_t x, uint16_t y, uint16_t color)
+{
+	uint16_t got = ili_read_pixel(x, y);
+	if (got == color)
+		return 0;
+	printf("%-24s %s: pixel (%u,%u) is %04x, expected %04x\n", "", what, x, y, got, color);
+	return 1;
+}
+
+/*
+ * Compare `n` pixels read back with `expected`, returns 1 (and prints it) if any differs
+ */
+static int _bench_compare(const char *what, const uint16_t *got, const uint16_t *expected, uint16_t n)
+{
+	for (uint16_t i = 0; i < n; i++)
+	{
+		if (got[i] != expected[i])
+		{
+			printf("%-24s %s: mismatch at pixel %u\n", "", what, i);
+			return 1;
+		}
+	}
+	return 0;
+}
+
+/*
+ * FNV-1a over the whole GRAM
+ */
+static uint32_t _bench_gram_checksum(void)
+{
+	uint32_t hash = 2166136261u;
+	const uint8_t *p = (const uint8_t *)ili_sim_gram;
+	for (uint32_t i = 0; i < sizeof(ili_sim_gram); i++)
+	{
+		hash ^= p[i];
+		hash *= 16777619u;
+	}
+	return hash;
+}
+
+
+int main(int argc, char *argv[])
+{
+	int failed = 0;
+
+	for (uint16_t i = 0; i < 16 * 16; i++)
+	{
+		uint16_t color = ILI_RGB((i & 15) << 4, (i >> 4) << 4, 128);
+		pattern_data[2*i] = (uint8_t)(color >> 8);
+		pattern_data[2*i + 1] = (uint8_t)color;
+	}
+	for (uint16_t i = 0; i < sizeof(bands_data); i++)
+	{
+		uint8_t index = (i / 4) / 4;				// 4 bytes per row, band changes every 4 rows
+		bands_data[i] = index * 0x55;				// same index in all four pixels of the byte
+	}
+
+	ili_init();
+	ili_rotate_display(1);
+
+	printf("%-24s %8s %8s %8s %9s %8s %10s\n", "call", "cmd", "param", "pixel", "strobes", "pixels", "bus_us");
+
+	BENCH("ili_fill_screen", ili_fill_screen(ILI_COLOR_CYAN));
+	BENCH("ili_fill_screen (hi=lo)", ili_fill_screen(ILI_COLOR_BLACK));
+	BENCH("ili_fill_rect", ili_fill_rect(20, 10, 80, 80, ILI_COLOR_PINK));
+	BENCH("ili_draw_rectangle", ili_draw_rectangle(5, 160, 50, 50, ILI_COLOR_WHITE));
+	failed |= _bench_expect("rectangle corner", 54, 209, ILI_COLOR_WHITE);
+	failed |= _bench_expect("rectangle outside", 55, 160, ILI_COLOR_BLACK);
+	failed |= _bench_expect("rectangle inside", 30, 185, ILI_COLOR_BLACK);
+	BENCH("ili_draw_line", ili_draw_line(4, 18, 200, 150, 1, ILI_COLOR_RED));
+	BENCH("ili_draw_line steep", ili_draw_line(30, 20, 60, 220, 1, ILI_COLOR_YELLOW));
+	BENCH("ili_draw_line shallow", ili_draw_line(0, 236, 319, 226, 1, ILI_COLOR_GREEN));
+	BENCH("ili_draw_line width 5", ili_draw_line(180, 2, 20, 230, 5, ILI_COLOR_BLUE));
+	BENCH("ili_draw_pixel", ili_draw_pixel(100, 100, ILI_COLOR_GREEN));
+	BENCH("ili_draw_char", ili_draw_char(200, 100, 'A', ILI_COLOR_RED, 0, &font_ubuntu_mono_24, 0));
+	BENCH("ili_draw_string", ili_draw_string(0, 0, "Hello world", ILI_COLOR_WHITE, &font_ubuntu_mono_24));
+	BENCH("ili_draw_string_withbg", ili_draw_string_withbg(10, 40, "Hello Solid World", ILI_COLOR_WHITE, ILI_COLOR_DARKGREEN, &font_ubuntu_mono_24));
+	BENCH("ili_draw_bitmap", ili_draw_bitmap(150, 200, &pattern));
+	BENCH("ili_dma_draw_bitmap", ili_dma_draw_bitmap(150, 220, &pattern));
+
+	// Read the bitmap back before anything else can draw over it
+	static uint16_t readback[16 * 16];
+	static uint16_t pattern_pixels[16 * 16];
+	for (uint16_t i = 0; i < 16 * 16; i++)
+		pattern_pixels[i] = ((uint16_t)pattern_data[2*i] << 8) | pattern_data[2*i + 1];
+	BENCH("ili_read_rect", ili_read_rect(150, 200, 16, 16, readback));
+	failed |= _bench_compare("ili_draw_bitmap", readback, pattern_pixels, 16 * 16);
+
+	BENCH("ili_draw_bitmap_rle", ili_draw_bitmap_rle(260, 200, &flag_rle));
+	failed |= _bench_expect("rle first run", 260, 200, 0x001F);
+	failed |= _bench_expect("rle first run end", 291, 215, 0x001F);
+	failed |= _bench_expect("rle literal", 260, 216, 0xF800);
+	failed |= _bench_expect("rle literal", 261, 216, 0x07E0);
+	failed |= _bench_expect("rle literal", 262, 216, 0x001F);
+	failed |= _bench_expect("rle literal", 263, 216, 0xFFFF);
+	failed |= _bench_expect("rle last run", 264, 216, 0xF800);
+	failed |= _bench_expect("rle last run end", 291, 231, 0xF800);
+	BENCH("ili_draw_bitmap_part", ili_draw_bitmap_part(132, 200, &pattern, 4, 4, 8, 8));
+	failed |= _bench_expect("bitmap part first", 132, 200, pattern_pixels[4 * 16 + 4]);
+	failed |= _bench_expect("bitmap part last", 139, 207, pattern_pixels[11 * 16 + 11]);
+	uint32_t stream_offset = 0;
+	BENCH("ili_draw_stream", ili_draw_stream(132, 212, 16, 16, _bench_stream_read, &stream_offset));
+	ili_read_rect(132, 212, 16, 16, readback);
+	failed |= _bench_compare("ili_draw_stream", readback, pattern_pixels, 16 * 16);
+	BENCH("ili_draw_bitmap_indexed", ili_draw_bitmap_indexed(110, 200, &bands));
+	failed |= _bench_expect("indexed band 0", 110, 200, ILI_COLOR_NAVY);
+	failed |= _bench_expect("indexed band 1", 125, 205, ILI_COLOR_OLIVE);
+	failed |= _bench_expect("indexed band 2", 110, 211, ILI_COLOR_MAROON);
+	failed |= _bench_expect("indexed band 3", 125, 215, ILI_COLOR_LIGHTGREY);
+	BENCH("ili_fill_circle", ili_fill_circle(250, 60, 25, ILI_COLOR_MAGENTA));
+	BENCH("ili_draw_circle", ili_draw_circle(250, 60, 30, ILI_COLOR_WHITE));
+	BENCH("ili_fill_ellipse", ili_fill_ellipse(250, 130, 40, 15, ILI_COLOR_GREENYELLOW));
+	BENCH("ili_draw_ellipse", ili_draw_ellipse(250, 130, 44, 19, ILI_COLOR_WHITE));
+	BENCH("ili_fill_round_rect", ili_fill_round_rect(215, 160, 70, 30, 8, ILI_COLOR_DARKCYAN));
+	BENCH("ili_draw_round_rect", ili_draw_round_rect(212, 157, 76, 36, 10, ILI_COLOR_WHITE));
+	BENCH("ili_fill_triangle", ili_fill_triangle(100, 130, 190, 150, 120, 195, ILI_COLOR_OLIVE));
+	BENCH("ili_fill_polygon non-zero", ili_fill_polygon(star, 5, ILI_FILL_NON_ZERO, ILI_COLOR_YELLOW));
+	failed |= _bench_expect("non-zero star center", 60, 50, ILI_COLOR_YELLOW);
+	failed |= _bench_expect("non-zero star arm", 60, 20, ILI_COLOR_YELLOW);
+	uint16_t star2_center = ili_read_pixel(60, 130);
+	BENCH("ili_fill_polygon even-odd", ili_fill_polygon(star2, 5, ILI_FILL_EVEN_ODD, ILI_COLOR_YELLOW));
+	failed |= _bench_expect("even-odd star center", 60, 130, star2_center);
+	failed |= _bench_expect("even-odd star arm", 60, 100, ILI_COLOR_YELLOW);
+	BENCH("ili_draw_thick_line round", ili_draw_thick_line(110, 20, 190, 60, 9, ILI_CAP_ROUND, ILI_COLOR_ORANGE));
+	BENCH("ili_draw_polyline miter", ili_draw_polyline(trace, 7, 5, ILI_CAP_BUTT, ILI_JOIN_MITER, ILI_COLOR_CYAN));
+	BENCH("ili_draw_line_aa", ili_draw_line_aa(10, 120, 100, 100, ILI_COLOR_WHITE, ILI_COLOR_BLACK));
+	BENCH("ili_draw_line_aa steep", ili_draw_line_aa(105, 95, 120, 140, ILI_COLOR_WHITE, ILI_COLOR_BLACK));
+	BENCH("ili_draw_circle_aa", ili_draw_circle_aa(60, 150, 25, ILI_COLOR_WHITE, ILI_COLOR_BLACK));
+	BENCH("ili_draw_circle clipped", ili_draw_circle(310, 230, 20, ILI_COLOR_RED));
+	// Pixels around the clip rectangle, they must not change
+	static uint16_t ring[4][100], ring_after[4][100];
+	ili_read_rect(0, 184, 100, 1, ring[0]);
+	ili_read_rect(0, 225, 100, 1, ring[1]);
+	ili_read_rect(9, 185, 1, 40, ring[2]);
+	ili_read_rect(90, 185, 1, 40, ring[3]);
+	ili_clip_push(10, 185, 80, 40);
+	BENCH("ili_fill_screen clip", ili_fill_screen(ILI_COLOR_DARKGREY));
+	failed |= _bench_expect("clip first pixel", 10, 185, ILI_COLOR_DARKGREY);
+	failed |= _bench_expect("clip last pixel", 89, 224, ILI_COLOR_DARKGREY);
+	BENCH("ili_draw_string clip", ili_draw_string_withbg(0, 178, "Clipped", ILI_COLOR_WHITE, ILI_COLOR_NAVY, &font_ubuntu_mono_24));
+	BENCH("ili_draw_bitmap clip", ili_draw_bitmap(82, 210, &pattern));
+	BENCH("ili_fill_circle clip", ili_fill_circle(20, 225, 18, ILI_COLOR_RED));
+	ili_clip_pop();
+	ili_read_rect(0, 184, 100, 1, ring_after[0]);
+	ili_read_rect(0, 225, 100, 1, ring_after[1]);
+	ili_read_rect(9, 185, 1, 40, ring_after[2]);
+	ili_read_rect(90, 185, 1, 40, ring_after[3]);
+	for (uint8_t i = 0; i < 4; i++)
+		failed |= _bench_compare("outside the clip", ring_after[i], ring[i], (i < 2) ? 100 : 40);
+
+	// Only the dirty rectangles may change, and both of them must: the redraw also differs at the '3'
+	static uint16_t panel[50][110], panel_after[50][110];
+	static const uint16_t dirty[2][4] = { {204, 184, 12, 24}, {252, 184, 12, 24} };
+	uint8_t changed[2] = { 0, 0 };
+	uint32_t outside = 0;
+	_bench_redraw_panel(0, 0, 0, 0, "12 34");
+	ili_read_rect(200, 180, 110, 50, &panel[0][0]);
+	ili_dirty_add(dirty[0][0], dirty[0][1], dirty[0][2], dirty[0][3]);
+	ili_dirty_add(dirty[1][0], dirty[1][1], dirty[1][2], dirty[1][3]);
+	BENCH("ili_dirty_flush", ili_dirty_flush(_bench_redraw_panel, "42 86"));
+	ili_read_rect(200, 180, 110, 50, &panel_after[0][0]);
+	for (uint16_t py = 0; py < 50; py++)
+	{
+		for (uint16_t px = 0; px < 110; px++)
+		{
+			uint8_t inside = 0;
+			for (uint8_t i = 0; i < 2; i++)
+			{
+				if (200 + px >= dirty[i][0] && 200 + px < dirty[i][0] + dirty[i][2] &&
+						180 + py >= dirty[i][1] && 180 + py < dirty[i][1] + dirty[i][3])
+				{
+					inside = 1;
+					if (panel_after[py][px] != panel[py][px])
+						changed[i] = 1;
+				}
+			}
+			if (!inside && panel_after[py][px] != panel[py][px])
+				outside++;
+		}
+	}
+	if (outside)
+	{
+		printf("%-24s dirty flush: %u pixels outside the regions changed\n", "", (unsigned)outside);
+		failed = 1;
+	}
+	if (!changed[0] || !changed[1])
+	{
+		printf("%-24s dirty flush: a region was not redrawn\n", "");
+		failed = 1;
+	}
+	ili_set_address_window(200, 180, 219, 199);
+	BENCH("ili_dma_fill_color", ili_dma_fill_color(ILI_COLOR_ORANGE, 20 * 20));
+
+	static uint16_t flush[32 * 8];
+	for (uint16_t i = 0; i < 32 * 8; i++)
+		flush[i] = ILI_RGB(i, (255 - i), ((i & 7) << 5));
+	BENCH("ili_write_pixels", ili_write_pixels(200, 10, 231, 17, flush));
+	ili_read_rect(200, 10, 32, 8, readback);
+	failed |= _bench_compare("ili_write_pixels", readback, flush, 32 * 8);
+
+	BENCH("ili_copy_rect", ili_copy_rect(150, 200, 158, 204, 16, 16));
+
+	BENCH("ili_te_wait", ili_te_wait());
+	printf("%-24s scanline after wait: %u\n", "", (unsigned)ili_get_scanline());
+
+	BENCH("ili_scroll_define", ili_scroll_define(20, 20));
+	BENCH("ili_scroll", ili_scroll(8));
+	// Every line on the panel shows the GRAM line ili_scroll_line() points to (rotation 1: x = panel line)
+	if (ili_sim_display_row(19) != 19 || ili_sim_display_row(20) != 28 || ili_sim_display_row(300) != 300)
+	{
+		printf("%-24s scroll: unexpected panel lines\n", "");
+		failed = 1;
+	}
+	for (uint16_t line = 0; line < 320; line++)
+	{
+		if (ili_sim_display_row(line) != ili_scroll_line(line))
+		{
+			printf("%-24s scroll: line %u shows %u, ili_scroll_line() says %u\n", "",
+				line, ili_sim_display_row(line), ili_scroll_line(line));
+			failed = 1;
+			break;
+		}
+	}
+	ili_scroll_define(0, 0);
+
+	printf("GRAM checksum: %08x\n", (unsigned)_bench_gram_checksum());
+
+#ifdef ILI_USE_STATS
+	// Same traffic as counted by the driver itself, accumulated per function
+	ili_stats_t stats[ILI_STATS_COUNT];
+	ili_stats_snapshot(stats);
+	printf("\n%-24s %8s %8s %8s %9s %8s\n", "driver stats", "calls", "cmd", "param", "pixel", "windows");
+	for (uint8_t api = 0; api < ILI_STATS_COUNT; api++)
+	{
+		if (stats[api].calls == 0 && stats[api].commands == 0)
+			continue;
+		printf("%-24s %8u %8u %8u %9u %8u\n", ili_stats_name(api),
+			(unsigned)stats[api].calls, (unsigned)stats[api].commands, (unsigned)stats[api].param_bytes,
+			(unsigned)stats[api].pixel_bytes, (unsigned)stats[api].window_sets);
+	}
+#endif
+
+	if (argc > 1 && ili_sim_dump_ppm(argv[1]) != 0)
+	{
+		printf("Could not write %s\n", argv[1]);
+		return 1;
+	}
+	// A pixel that differs from what was drawn fails the run
+	if (failed)
+		printf("FAILED\n");
+	return failed;
+}
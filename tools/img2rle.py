@@ -0,0 +1,109 @@
+#!/usr/bin/env python3
+#
+# MIT License
+#
+# Copyright (c) 2020 Avra Mitra
+#
+# Permission is hereby granted, free of charge, to any person obtaining a copy
+# of this software and associated documentation files (the "Software"), to deal
+# in the Software without restriction, including without limitation the rights
+# to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+# copies of the Software, and to permit persons to whom the Software is
+# furnished to do so, subject to the following conditions:
+#
+# The above copyright notice and this permission notice shall be included in all
+# copies or substantial portions of the Software.
+#
+# THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+# IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+# FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+# AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+# LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+# OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+# SOFTWARE.
+
+"""
+Convert a binary PPM (P6) image to a tImageRLE C header for ili_draw_bitmap_rle().
+Most image editors can export PPM, and the simulator dumps its GRAM as PPM.
+
+usage: img2rle.py image.ppm name > image_name.h
+"""
+
+import sys
+
+
+def read_ppm(path):
+    with open(path, 'rb') as f:
+        data = f.read()
+    fields = []
+    pos = 0
+    # magic, width, height, maxval; comments start with '#'
+    while len(fields) < 4:
+        while data[pos:pos + 1].isspace():
+            pos += 1
+        if data[pos:pos + 1] == b'#':
+            pos = data.index(b'\n', pos)
+            continue
+        start = pos
+        while not data[pos:pos + 1].isspace():
+            pos += 1
+        fields.append(data[start:pos])
+    if fields[0] != b'P6' or int(fields[3]) != 255:
+        sys.exit('only 8-bit binary PPM (P6) is supported')
+    width, height = int(fields[1]), int(fields[2])
+    rgb = data[pos + 1:pos + 1 + width * height * 3]
+    pixels = [((rgb[i] & 0xF8) << 8) | ((rgb[i + 1] & 0xFC) << 3) | (rgb[i + 2] >> 3)
+              for i in range(0, len(rgb), 3)]
+    return width, height, pixels
+
+
+def encode(pixels):
+    out = bytearray()
+    literal = []
+
+    def flush_literal():
+        while literal:
+            chunk = literal[:128]
+            del literal[:128]
+            out.append(len(chunk) - 1)
+            for color in chunk:
+                out.extend((color >> 8, color & 0xFF))
+
+    i = 0
+    while i < len(pixels):
+        run = 1
+        while i + run < len(pixels) and pixels[i + run] == pixels[i] and run < 16384:
+            run += 1
+        # A run of 2 only pays off when it does not split a literal
+        if run >= 3 or (run == 2 and not literal):
+            flush_literal()
+            if run <= 64:
+                out.append(0x80 | (run - 1))
+            else:
+                out += bytes((0xC0 | ((run - 1) >> 8), (run - 1) & 0xFF))
+            out += bytes((pixels[i] >> 8, pixels[i] & 0xFF))
+        else:
+            literal.extend(pixels[i:i + run])
+        i += run
+    flush_literal()
+    return out
+
+
+def main():
+    if len(sys.argv) != 3:
+        sys.exit(__doc__.strip())
+    width, height, pixels = read_ppm(sys.argv[1])
+    name = sys.argv[2]
+    data = encode(pixels)
+
+    print('// %dx%d, %d bytes RLE (%d bytes raw)' % (width, height, len(data), width * height * 2))
+    print('#include "bitmap_typedefs.h"\n')
+    print('static const uint8_t image_data_%s[%d] = {' % (name, len(data)))
+    for i in range(0, len(data), 16):
+        print('    ' + ', '.join('0x%02x' % b for b in data[i:i + 16]) + ',')
+    print('};\n')
+    print('static const tImageRLE %s = { image_data_%s, %d, %d, %d };' % (name, name, len(data), width, height))
+
+
+if __name__ == '__main__':
+    main()